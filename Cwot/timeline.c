@@ -0,0 +1,281 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * wot-timeline: when did two keys first end up on the same island?
+ *
+ * The dated signatures of a process-keys.py style file are replayed
+ * in date order through a union-find that remembers the date of every
+ * merge (see wg_tuf_when()), ignoring their direction: two keys are
+ * on one island once a chain of signatures of either direction joins
+ * them. Afterwards every query takes O(log n), without rebuilding the
+ * graph for any date.
+ */
+
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "wotgraph.h"
+
+/* hex digits of a wg_keyid_t */
+#define KEYID_MAXLEN 16
+
+static int      idlen = 16;
+static uint32_t minsize = 0;
+
+/*
+ * Numbers of the dated edges of e in date order, a counting sort over
+ * the days from the first to the last date. Returns how many there are.
+ */
+static size_t
+date_order(const struct wg_edges * e, size_t ** order)
+{
+	int32_t         lo = WG_NODATE, hi = INT32_MIN;
+	size_t          i, n = 0, *cnt, *ord, sum, c, span, d;
+
+	for (i = 0; i < e->n; i++) {
+		if (e->date[i] == WG_NODATE)
+			continue;
+		lo = e->date[i] < lo ? e->date[i] : lo;
+		hi = e->date[i] > hi ? e->date[i] : hi;
+		n++;
+	}
+	*order = ord = (size_t *) wg_malloc(n * sizeof(size_t));
+	if (n == 0)
+		return 0;
+
+	span = (size_t) ((int64_t) hi - lo) + 1;
+	cnt = (size_t *) wg_calloc(span, sizeof(size_t));
+	for (i = 0; i < e->n; i++) {
+		if (e->date[i] != WG_NODATE)
+			cnt[e->date[i] - lo]++;
+	}
+	for (sum = 0, d = 0; d < span; d++) {
+		c = cnt[d];
+		cnt[d] = sum;
+		sum += c;
+	}
+	for (i = 0; i < e->n; i++) {
+		if (e->date[i] != WG_NODATE)
+			ord[cnt[e->date[i] - lo]++] = i;
+	}
+	free(cnt);
+	return n;
+}
+
+/*
+ * Replay the signatures in order. With -T every merge of two islands
+ * of at least minsize keys is printed as
+ *
+ *	yyyy-mm-dd;<key>;<size>;<key>;<size>
+ *
+ * the first island being the larger one, which goes on under the
+ * same key. Together these lines are the tree of islands growing
+ * into the present ones.
+ */
+static void
+replay(struct wg_tuf * u, const struct wg_graph * g, const size_t * order,
+       size_t n)
+{
+	const struct wg_edges *e = &g->sigs;
+	char            ida[KEYID_MAXLEN + 1], idb[KEYID_MAXLEN + 1], date[11];
+	uint32_t        a, b, t;
+	size_t          i;
+
+	for (i = 0; i < n; i++) {
+		a = wg_tuf_find(u, e->src[order[i]]);
+		b = wg_tuf_find(u, e->dst[order[i]]);
+		if (a == b)
+			continue;
+		if (u->size[a] < u->size[b]) {
+			t = a;
+			a = b;
+			b = t;
+		}
+		if (minsize > 0 && u->size[b] >= minsize) {
+			printf("%s;%s;%u;%s;%u\n",
+			       wg_date_format(e->date[order[i]], date),
+			       wg_keyid_format(g->keys.ids[a], idlen, ida), u->size[a],
+			       wg_keyid_format(g->keys.ids[b], idlen, idb), u->size[b]);
+		}
+		wg_tuf_union(u, a, b, e->date[order[i]]);
+	}
+}
+
+/* Answer one query, a and b being key ids as given */
+static void
+query(const struct wg_tuf * u, const struct wg_graph * g, const char *a,
+      const char *b)
+{
+	wg_keyid_t      ida, idb;
+	int64_t         va = -1, vb = -1;
+	int32_t         when;
+	char            date[11];
+
+	if ((int) strlen(a) == idlen && wg_keyid_parse(a, idlen, &ida) == 0)
+		va = wg_idtab_find(&g->keys, ida);
+	if ((int) strlen(b) == idlen && wg_keyid_parse(b, idlen, &idb) == 0)
+		vb = wg_idtab_find(&g->keys, idb);
+	if (va < 0 || vb < 0) {
+		printf("%s;%s;unknown\n", a, b);
+		return;
+	}
+	when = wg_tuf_when(u, (uint32_t) va, (uint32_t) vb);
+	if (when == WG_NODATE) {
+		printf("%s;%s;never\n", a, b);
+	} else if (when == INT32_MIN) {
+		printf("%s;%s;always\n", a, b);
+	} else {
+		printf("%s;%s;%s\n", a, b, wg_date_format(when, date));
+	}
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: wot-timeline [-l num] [-T num] file [keyid keyid ...]\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "\tfile is process-keys.py output, s lines carry dates\n");
+	fprintf(stderr, "\t(s<keyid>;yyyy-mm-dd;...). Prints the date from which\n");
+	fprintf(stderr, "\ton each pair of keys is on one island, as\n");
+	fprintf(stderr, "\t\"keyid;keyid;yyyy-mm-dd\" (or never). Without key ids\n");
+	fprintf(stderr, "\tthe pairs are read from stdin, one pair per line.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "\t-l num\tkey ids are num hex digits long (default 16)\n");
+	fprintf(stderr, "\t-T num\tfirst print every merge of two islands of at least\n");
+	fprintf(stderr, "\t\tnum keys each\n");
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct wg_graph graph;
+	struct wg_tuf   uf;
+	struct timeval  tvphase;
+	size_t         *order, ndated, len;
+	uint32_t        v, r, big = 0;
+	int32_t         since = INT32_MIN;
+	char            line[1024], *a, *b, date[11];
+	FILE           *in;
+	int             ch, i;
+
+	while ((ch = getopt(argc, argv, "l:T:")) != -1) {
+		switch (ch) {
+		case 'l':
+			idlen = (int) strtoul(optarg, NULL, 10);
+			if (idlen < 1 || idlen > KEYID_MAXLEN) {
+				fprintf(stderr, "ids are 1 to %d chars long\n", KEYID_MAXLEN);
+				exit(1);
+			}
+			break;
+		case 'T':
+			minsize = (uint32_t) strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage();
+			/* not reached */
+			break;
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc < 1 || argc % 2 == 0) {
+		usage();
+	}
+
+	wg_lap(&tvphase);
+	if ((in = fopen(argv[0], "r")) == NULL) {
+		fprintf(stderr, "Error opening %s: %s\n", argv[0], strerror(errno));
+		exit(1);
+	}
+	if (wg_load(&graph, in, idlen, WG_SKIP_SELFSIGS | WG_DATES) != 0) {
+		fprintf(stderr, "Error reading %s: %s\n", argv[0], strerror(errno));
+		exit(1);
+	}
+	fclose(in);
+	fprintf(stderr, "Read %u keys and %lu signatures\n", graph.keys.n,
+		(unsigned long) graph.sigs.n);
+	fprintf(stderr, "Parsing took %.3f seconds\n", wg_lap(&tvphase));
+
+	ndated = date_order(&graph.sigs, &order);
+	if (ndated < graph.sigs.n) {
+		fprintf(stderr, "%lu signatures without a date skipped\n",
+			(unsigned long) (graph.sigs.n - ndated));
+	}
+	if (ndated == 0) {
+		fprintf(stderr, "No dated signatures in %s\n", argv[0]);
+		exit(1);
+	}
+	wg_tuf_init(&uf, graph.keys.n);
+	replay(&uf, &graph, order, ndated);
+	free(order);
+
+	/* the largest island, and the date it was completed */
+	for (v = 0; v < graph.keys.n; v++) {
+		r = wg_tuf_find(&uf, v);
+		if (uf.size[r] > uf.size[big] ||
+		    (uf.size[r] == uf.size[big] && r < big)) {
+			big = r;
+		}
+	}
+	for (v = 0; v < graph.keys.n; v++) {
+		if (v != big && uf.parent[v] != v &&
+		    wg_tuf_find(&uf, v) == big && uf.when[v] > since) {
+			since = uf.when[v];
+		}
+	}
+	if (since != INT32_MIN) {
+		fprintf(stderr, "The largest island has %u keys, complete since %s\n",
+			uf.size[big], wg_date_format(since, date));
+	}
+	fprintf(stderr, "Replay took %.3f seconds\n", wg_lap(&tvphase));
+
+	if (argc > 1) {
+		for (i = 1; i + 1 < argc; i += 2) {
+			query(&uf, &graph, argv[i], argv[i + 1]);
+		}
+	} else {
+		/* "keyid keyid" or "keyid;keyid" per line */
+		while (fgets(line, sizeof(line), stdin)) {
+			len = strlen(line);
+			while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+				line[--len] = '\0';
+			if ((a = strtok(line, " \t;")) == NULL ||
+			    (b = strtok(NULL, " \t;")) == NULL) {
+				continue;
+			}
+			query(&uf, &graph, a, b);
+		}
+	}
+	fprintf(stderr, "Queries took %.3f seconds\n", wg_lap(&tvphase));
+
+	wg_tuf_free(&uf);
+	wg_graph_free(&graph);
+	return 0;
+}
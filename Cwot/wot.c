@@ -23,14 +23,6 @@
  *
  */
 
-#ifndef NOQUEUE
-#include <sys/queue.h>
-#include <sys/tree.h>
-#else
-#include "sys/queue.h"
-#include "sys/tree.h"
-#endif				/* NOQUEUE */
-
 #include <sys/time.h>
 #include <math.h>
 #include <stdio.h>
@@ -40,12 +32,69 @@
 #include <search.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "wotgraph.h"
+
+/*
+ * Key ids are stored as integers and only turned into hex on output.
+ * 32 bit ids are enough for short (-l 8) key ids, see the Makefile.
+ */
+#ifndef KEYID_BITS
+#define KEYID_BITS 64
+#endif
+
+#if KEYID_BITS == 64
+typedef uint64_t keyid_t;
+#define PRIXKEY PRIX64
+#elif KEYID_BITS == 32
+typedef uint32_t keyid_t;
+#define PRIXKEY PRIX32
+#else
+#error "KEYID_BITS must be 32 or 64"
+#endif
+
+#define KEYID_MAXLEN (KEYID_BITS / 4)
+
+/* printf format of a key id, takes idlen and the id */
+#define KEYFMT "%0*" PRIXKEY
 
 #define COMPFILE "maximal.compound"
-#define NUM_ATTRIBS 2
+#define ISLANDFILE "islands.txt"
+#define EDGEFILE "edges.txt"
+
+/* num of vertices outside the component */
+#define NOT_NUMBERED UINT32_MAX
+
+/*
+ * Sources of one batched traversal (-b), at most 32. Each vertex
+ * keeps BATCH wide sigma and delta vectors, which the compiler can
+ * map onto SIMD lanes (try adding -march=native to CFLAGS).
+ */
+#ifndef BATCH
+#define BATCH 8
+#endif
+
+#if BATCH < 1 || BATCH > 32
+#error "BATCH must be between 1 and 32"
+#endif
+
+/* sources a worker takes at a time, a multiple of BATCH */
+#define CHUNK (2 * BATCH)
+
+/* vertices a two-hop worker takes at a time */
+#define TWOHOP_CHUNK 256
 
-#define VR 0
-#define CR 1
+/* -t: sources of the first round, doubled every round */
+#define TOPK_FIRST 256
+
+/* -t without -a: intervals narrower than this part of the k-th estimate are clear */
+#define TOPK_TOL 0.2
+
+/* -2: count exactly unless that looks at more edges than this */
+#define HUBWORK 1000000
 
 extern int      optind;
 extern int      optopt;
@@ -53,635 +102,1711 @@ extern int      opterr;
 extern int      optreset;
 int             debug = 0;
 int             dumpflag = 0;
-int             idlen = 16;
-
-LIST_HEAD(listhead, _listelem);
-TAILQ_HEAD(tailqhead, _listelem);
-RB_HEAD(node_tree, _vertex) nodeshead = RB_INITIALIZER(&nodeshead);
-RB_HEAD(sort_tree, _sortelem) sorthead = RB_INITIALIZER(&sorthead);
-RB_PROTOTYPE(node_tree, _vertex, nnode, vertcmp);
-RB_PROTOTYPE(sort_tree, _sortelem, snode, sortcmp);
-
-struct _listelem {
-	/* _listelem can be a member of a LIST xor a TAILQueue */
-	LIST_ENTRY(_listelem) sl_elem;
-	TAILQ_ENTRY(_listelem) tq_elem;
-	struct _vertex *vert;
+int             strongflag = 0;
+int             degreeflag = 0;
+int             twohopflag = 0;
+int             edgeflag = 0;
+int             reverseflag = 0;
+size_t          hubwork = HUBWORK;
+uint32_t        ncut = 0;
+uint32_t        topk = 0;
+uint32_t        ntop = 0;
+char           *compfile = NULL;
+char           *cutfile = NULL;
+int             nthreads = 1;
+double          epsilon = 0.0;
+double          delta = 0.1;
+int             idlen = KEYID_MAXLEN;
+
+/*
+ * Per-source state of Brandes' algorithm, indexed by vertex number.
+ * The BFS queue doubles as the stack: vertices leave the queue in
+ * order of non-decreasing distance, so walking it backwards visits
+ * them in the order Brandes pops them. There are no predecessor
+ * lists: the predecessors of w on shortest paths are the signers v
+ * of w with dist[v] == dist[w] - 1, found by walking the reverse
+ * adjacency. bdelta is the dependency counting unique shortest paths
+ * only, for bridge centrality.
+ *
+ * One of these is allocated per thread and reused for every source,
+ * so a round does no allocation at all.
+ */
+struct brandes {
+	double         *sigma;
+	double         *delta;
+	double         *bdelta;
+	int            *dist;
+	uint32_t       *queue;
 };
 
-/* RB_TREE for sorting by centrality */
-/* XXX Heap would be nicer */
-struct _sortelem {
-	double          centrality;
+/*
+ * State of the batched kernel: BATCH sources share one traversal, so
+ * each adjacency list read serves all of them. Vertex v's lane k is
+ * at [v * BATCH + k]; bit k of a lane mask stands for the k-th source.
+ * The traversal is recorded as (vertex, lanes) entries grouped by
+ * distance, level d being entries level[d] .. level[d+1] - 1; a
+ * vertex appears once at every distance some source reaches it at,
+ * hence at most n * BATCH entries.
+ */
+struct msbrandes {
+	double         *sigma;
+	double         *coef;
+	double         *bcoef;
+	uint32_t       *seen;
+	uint32_t       *next;
+	uint32_t       *at[2];
+	uint32_t       *ent;
+	uint32_t       *lanes;
+	uint32_t       *level;
+};
 
-	/* Head of a LIST of vertices with this centrality */
-	struct listhead *vertices;
+/*
+ * What the traversals add up: dependencies and bridge dependencies of
+ * every vertex and, unless NULL, of every edge (indexed like the
+ * reverse adjacency, -e) and the squares of the dependencies on the
+ * single sources (-t).
+ */
+struct brandes_sums {
+	double         *centrality;
+	double         *bridge;
+	double         *edge;
+	double         *sq;
+};
 
-	/* _sortelem is a member of a tree for sorting wrt centrality */
-	                RB_ENTRY(_sortelem) snode;
+/*
+ * Sources still to do, shared by the workers. Each worker takes the
+ * next CHUNK entries of sources under the lock and sums their
+ * dependencies up in a partial sums of its own. The partials are
+ * added to out one chunk after the other, in the order of sources,
+ * so the result is the same for any number of threads: a worker that
+ * is done with a chunk waits until all chunks before it are added.
+ */
+struct brandes_job {
+	const struct wg_csr *succ;
+	const struct wg_csr *pred;
+	const keyid_t  *index;
+	const uint32_t *sources;
+	uint32_t        nsources;
+	const size_t   *epos;	/* -e -b: position in pred of each succ edge */
+	struct brandes_sums *out;
+	pthread_mutex_t lock;
+	pthread_cond_t  added;	/* another chunk is added to out */
+	uint32_t        next;
+	uint32_t        nadded;	/* sources whose chunks are in out */
+	uint32_t        done;
+	struct timeval  start;
 };
 
+int             batched = 0;
+
+struct brandes_worker {
+	struct brandes_job *job;
+	struct brandes_sums sums;	/* of the chunk at hand */
+	pthread_t       thread;
+};
+
+struct brandes *
+brandes_alloc(const struct wg_csr * g)
+{
+	struct brandes *b;
+	uint32_t        v;
+
+	b = (struct brandes *) wg_malloc(sizeof(struct brandes));
+	b->sigma = (double *) wg_malloc(g->n * sizeof(double));
+	b->delta = (double *) wg_malloc(g->n * sizeof(double));
+	b->bdelta = (double *) wg_malloc(g->n * sizeof(double));
+	b->dist = (int *) wg_malloc(g->n * sizeof(int));
+	b->queue = (uint32_t *) wg_malloc(g->n * sizeof(uint32_t));
+
+	for (v = 0; v < g->n; v++) {
+		b->sigma[v] = 0.0;
+		b->delta[v] = 0.0;
+		b->bdelta[v] = 0.0;
+		b->dist[v] = -1;
+	}
+	return b;
+}
+
+void
+brandes_free(struct brandes * b)
+{
+	free(b->sigma);
+	free(b->delta);
+	free(b->bdelta);
+	free(b->dist);
+	free(b->queue);
+	free(b);
+}
+
 /*
- * Our main structure to store keys and their relations.
+ * vertex_round
+ * 
+ * round-function to be called for each vertex of the graph. updates the
+ * centrality of vertices on every shortest path from the given vertex to
+ * every other.
+ * 
+ * Algorithm was presented by Ulrik Brandes in "A Faster Algorithm for
+ * Betweennes Centrality" in "Journal of Mathematical Sociology",
+ * 25(5):163-177, 2001.
+ * 
+ * Earlier implementations used a modified Floyd-Warshall, and were way
+ * too slow.
+ *
+ * g is the graph, rg its reverse and index maps vertex numbers back
+ * to vertices for debugging output. b must be in its initial state
+ * (see brandes_alloc()) and is left that way.
+ *
+ * bridge[] gets bridge centrality: the same dependencies, counting
+ * only pairs connected by a single shortest path. Those paths form a
+ * tree, the vertices with sigma == 1, in which every vertex has just
+ * one predecessor, so the sums ride along the same backward sweep.
+ *
+ * If edge is not NULL, edge[e] gets the dependency on the signature
+ * rg->adj[e] -> w, e being its position in rg.
  */
-struct _vertex {
-	char           *id;
-	double          centrality;
 
-	/* Lists of successors and predecessors */
-	struct listhead *successors;
-	                LIST_ENTRY(_listelem) entries;
+void
+vertex_round(uint32_t s, const struct wg_csr * g, const struct wg_csr * rg,
+	     const keyid_t * index, struct brandes * b, struct brandes_sums * out)
+{
+	double         *centrality = out->centrality, *bridge = out->bridge;
+	double         *edge = out->edge, *sq = out->sq;
+	uint32_t        v, w, head = 0, tail = 0, i;
+	size_t          e;
+	double          ftmp, c;
 
-	struct listhead *predecessors;
-	                LIST_ENTRY(_listelem) pentries;
+	b->sigma[s] = 1.0;
+	b->dist[s] = 0;
+	b->queue[tail++] = s;
 
-	/*
-	 * _vertex is a member of a tree for lookups by name
-	 * and for uniqueness
-	 */
-	                RB_ENTRY(_vertex) nnode;
+	if (debug) {
+		fprintf(stderr, "working on " KEYFMT ": \n ", idlen, index[s]);
+	}
+	while (head < tail) {
+		v = b->queue[head++];
 
-	/*
-	 * array of pointers to attributes XXX only one (vr_attr) is defined
-	 */
-	void           *attribs[NUM_ATTRIBS];
+		if (debug) {
+			fprintf(stderr, "Neighbors of " KEYFMT ": \n", idlen, index[v]);
+		}
+		/* iterate over the neighbors */
+		for (e = g->off[v]; e < g->off[v + 1]; e++) {
+			w = g->adj[e];
+			if (debug) {
+				fprintf(stderr, KEYFMT ",", idlen, index[w]);
+			}
+			/* Seen the first time? */
+			if (b->dist[w] < 0) {
+				b->queue[tail++] = w;
+				b->dist[w] = b->dist[v] + 1;
+			}
+			/* On shortest path to w via v? */
+			if (b->dist[w] == b->dist[v] + 1) {
+				b->sigma[w] += b->sigma[v];
+			}
+		}
+		if (debug) {
+			fprintf(stderr, "\n\t" KEYFMT " has %d neighbors\n", idlen,
+				index[v], (int) (g->off[v + 1] - g->off[v]));
+		}
+	}
 
-	/* "distance" attribute, used in BFS routines a lot */
-	double          d;
-};
+	if (debug) {
+		fprintf(stderr, "Stackheight %u\n", tail);
+	}
+	/* pop the stack, the source is at the bottom and has no predecessors */
+	for (i = tail; i-- > 1;) {
+		w = b->queue[i];
 
-typedef struct _vertex *vertex;
+		if (debug) {
+			fprintf(stderr, "\tStack " KEYFMT "\n", idlen, index[w]);
+		}
+		/* go through the signers of w that precede it */
+		for (e = rg->off[w]; e < rg->off[w + 1]; e++) {
+			v = rg->adj[e];
+			if (b->dist[v] != b->dist[w] - 1) {
+				continue;
+			}
 
-/* vertex attributes used in Brandes' algorithm */
-struct vr_attr {
-	double          sigma;
-	double          delta;
-	struct tailqhead *P;
-};
+			if (debug) {
+				fprintf(stderr, "\t\tList " KEYFMT "\n", idlen, index[v]);
+			}
+			c = (b->sigma[v] / b->sigma[w]) * (1.0 + b->delta[w]);
+			ftmp = b->delta[v] + c;
+			if (edge != NULL) {
+				edge[e] += c;
+			}
 
-struct vr_attr *
-vr_alloc(void)
-{
-	struct vr_attr *new;
-	struct tailqhead *p;
+			/*
+			 * Did something go _terribly_, numerically
+			 * wrong?
+			 */
+			if (isinf(ftmp) || isnan(ftmp)) {
+				fprintf(stderr, " " KEYFMT "->delta= %f\t " KEYFMT "->sigma= %f \t "
+					KEYFMT "->sigma=%f \t " KEYFMT "->delta=%f\n",
+					idlen, index[v], b->delta[v],
+					idlen, index[v], b->sigma[v],
+					idlen, index[w], b->sigma[w],
+					idlen, index[w], b->delta[w]);
+				/* force core-dump */
+				kill(getpid(), SIGSEGV);
+			}
+			b->delta[v] = ftmp;
 
-	if ((new = (struct vr_attr *) malloc(sizeof(struct vr_attr))) == NULL) {
-		fprintf(stderr, "malloc failed\n");
-		exit(2);
+			/* v is the only predecessor of w then */
+			if (b->sigma[w] == 1.0) {
+				b->bdelta[v] += 1.0 + b->bdelta[w];
+			}
+		}
+		centrality[w] += b->delta[w];
+		bridge[w] += b->bdelta[w];
+		if (sq != NULL) {
+			sq[w] += b->delta[w] * b->delta[w];
+		}
 	}
-	if ((p = (struct tailqhead *) malloc(sizeof(struct tailqhead))) == NULL) {
-		fprintf(stderr, "malloc failed\n");
-		exit(2);
+
+	/* back to the initial state, touching only what we used */
+	for (i = 0; i < tail; i++) {
+		w = b->queue[i];
+		b->sigma[w] = 0.0;
+		b->delta[w] = 0.0;
+		b->bdelta[w] = 0.0;
+		b->dist[w] = -1;
 	}
-	new->sigma = 0.0;
-	new->delta = 0.0;
-	TAILQ_INIT(p);
-	new->P = p;
-	return new;
 }
 
-void 
-vr_free(struct vr_attr * vr)
+struct msbrandes *
+msbrandes_alloc(const struct wg_csr * g)
 {
-	struct tailqhead *p;
-	if (vr == NULL) {
-		return;
+	struct msbrandes *b;
+	size_t          nk = (size_t) g->n * BATCH, i;
+
+	b = (struct msbrandes *) wg_malloc(sizeof(struct msbrandes));
+	b->sigma = (double *) wg_malloc(nk * sizeof(double));
+	b->coef = (double *) wg_malloc(nk * sizeof(double));
+	b->bcoef = (double *) wg_malloc(nk * sizeof(double));
+	b->seen = (uint32_t *) wg_calloc(g->n, sizeof(uint32_t));
+	b->next = (uint32_t *) wg_calloc(g->n, sizeof(uint32_t));
+	b->at[0] = (uint32_t *) wg_calloc(g->n, sizeof(uint32_t));
+	b->at[1] = (uint32_t *) wg_calloc(g->n, sizeof(uint32_t));
+	b->ent = (uint32_t *) wg_malloc(nk * sizeof(uint32_t));
+	b->lanes = (uint32_t *) wg_malloc(nk * sizeof(uint32_t));
+	b->level = (uint32_t *) wg_malloc((g->n + 3) * sizeof(uint32_t));
+
+	for (i = 0; i < nk; i++) {
+		b->sigma[i] = 0.0;
+		b->coef[i] = 0.0;
+		b->bcoef[i] = 0.0;
 	}
-	p = vr->P;
-	if (p == NULL) {
-		free(vr);
-		return;
+	return b;
+}
+
+void
+msbrandes_free(struct msbrandes * b)
+{
+	free(b->sigma);
+	free(b->coef);
+	free(b->bcoef);
+	free(b->seen);
+	free(b->next);
+	free(b->at[0]);
+	free(b->at[1]);
+	free(b->ent);
+	free(b->lanes);
+	free(b->level);
+	free(b);
+}
+
+/*
+ * batch_round
+ *
+ * vertex_round() for the nsrc <= BATCH sources src[] at once. A level
+ * synchronous BFS advances all sources together (multi-source BFS
+ * after Then et al., "The More the Merrier", VLDB 2014): a vertex is
+ * expanded once per level for every source that reached it there.
+ * The dependencies are accumulated backwards level by level. The lane
+ * loops have no data dependent branches
+ * so they vectorize, and the reverse adjacency is not needed.
+ *
+ * Sums are formed in another order than in vertex_round(), so the
+ * last digits of the result may differ.
+ */
+
+void
+batch_round(const uint32_t * src, int nsrc, const struct wg_csr * g,
+	    struct msbrandes * b, struct brandes_sums * sums, const size_t * epos)
+{
+	double         *centrality = sums->centrality, *bridge = sums->bridge;
+	double         *edge = sums->edge, *sq = sums->sq;
+	uint32_t        v, w, m, nm, nent = 0, e, first, d, nlevels;
+	size_t          j, wk;
+	double          acc[BATCH], bacc[BATCH], sum, bsum, sqsum, on, delta, bdelta;
+	double          esum;
+	double         *sv, *sw, *cv, *cw, *bv, *bw;
+	uint32_t       *cur, *out;
+	int             k;
+
+	for (k = 0; k < nsrc; k++) {
+		v = src[k];
+		b->sigma[(size_t) v * BATCH + k] = 1.0;
+		b->seen[v] = 1U << k;
+		b->ent[nent] = v;
+		b->lanes[nent++] = 1U << k;
+	}
+	b->level[0] = 0;
+
+	/* forward: shared frontier expansion */
+	for (d = 0; b->level[d] < nent; d++) {
+		first = nent;
+		b->level[d + 1] = first;
+		for (e = b->level[d]; e < first; e++) {
+			v = b->ent[e];
+			m = b->lanes[e];
+			sv = b->sigma + (size_t) v * BATCH;
+			for (j = g->off[v]; j < g->off[v + 1]; j++) {
+				w = g->adj[j];
+				/* sources that reach w for the first time via v */
+				if ((nm = m & ~b->seen[w]) == 0) {
+					continue;
+				}
+				if (b->next[w] == 0) {
+					b->ent[nent++] = w;
+				}
+				b->next[w] |= nm;
+				sw = b->sigma + (size_t) w * BATCH;
+				for (k = 0; k < BATCH; k++) {
+					sw[k] += sv[k] * (double) ((nm >> k) & 1);
+				}
+			}
+		}
+		/* close the level */
+		for (e = first; e < nent; e++) {
+			w = b->ent[e];
+			m = b->lanes[e] = b->next[w];
+			b->seen[w] |= m;
+			b->next[w] = 0;
+		}
+	}
+	nlevels = d;
+	b->level[nlevels + 1] = nent;
+
+	/*
+	 * backward, levels in decreasing distance with the sources
+	 * excluded. Each vertex pulls the dependencies from its
+	 * successors one level further out, so only its own lanes are
+	 * written: delta[v] = sigma[v] * sum of coef[w] over them, and
+	 * coef[v] = (1 + delta[v]) / sigma[v] is kept for the next level.
+	 * Likewise for bridge centrality, bcoef[v] = 1 + bdelta[v] where
+	 * sigma[v] == 1 and 0 elsewhere.
+	 * at[d & 1][w] are the lanes w is at distance d on, so most
+	 * edges are skipped without touching the lane vectors.
+	 * The dependency on the edge v -> w is sigma[v] * coef[w], added
+	 * up over the lanes of w; edge[] is indexed like the reverse
+	 * adjacency, epos[] maps g's positions there.
+	 */
+	for (d = nlevels; d-- > 1;) {
+		cur = b->at[d & 1];
+		out = b->at[(d + 1) & 1];
+		for (e = b->level[d]; e < b->level[d + 1]; e++) {
+			v = b->ent[e];
+			m = b->lanes[e];
+			for (k = 0; k < BATCH; k++) {
+				acc[k] = 0.0;
+				bacc[k] = 0.0;
+			}
+			sv = b->sigma + (size_t) v * BATCH;
+			for (j = g->off[v]; j < g->off[v + 1]; j++) {
+				w = g->adj[j];
+				if ((nm = m & out[w]) == 0) {
+					continue;
+				}
+				cw = b->coef + (size_t) w * BATCH;
+				bw = b->bcoef + (size_t) w * BATCH;
+				for (k = 0; k < BATCH; k++) {
+					on = (double) ((nm >> k) & 1);
+					acc[k] += cw[k] * on;
+					bacc[k] += bw[k] * on;
+				}
+				if (edge != NULL) {
+					for (esum = 0.0, k = 0; k < BATCH; k++) {
+						esum += sv[k] * cw[k] * (double) ((nm >> k) & 1);
+					}
+					edge[epos[j]] += esum;
+				}
+			}
+			/* sigma of lanes not on this level may be 0 */
+			sum = bsum = sqsum = 0.0;
+			cv = b->coef + (size_t) v * BATCH;
+			bv = b->bcoef + (size_t) v * BATCH;
+			for (k = 0; k < BATCH; k++) {
+				on = (double) ((m >> k) & 1);
+				delta = on * sv[k] * acc[k];
+				sum += delta;
+				sqsum += delta * delta;
+				cv[k] = on * (1.0 + delta) / (sv[k] + 1.0 - on) +
+					(1.0 - on) * cv[k];
+				bdelta = on * bacc[k];
+				bsum += bdelta;
+				bv[k] = on * (double) (sv[k] == 1.0) * (1.0 + bdelta) +
+					(1.0 - on) * bv[k];
+			}
+			centrality[v] += sum;
+			bridge[v] += bsum;
+			if (sq != NULL) {
+				sq[v] += sqsum;
+			}
+			cur[v] = m;
+		}
+		/* level d + 1 is done with */
+		for (e = b->level[d + 1]; e < b->level[d + 2]; e++) {
+			out[b->ent[e]] = 0;
+		}
+	}
+
+	/* the sources have no dependencies, but their edges do */
+	if (edge != NULL && nlevels > 1) {
+		out = b->at[1];
+		for (e = 0; e < b->level[1]; e++) {
+			v = b->ent[e];
+			m = b->lanes[e];
+			sv = b->sigma + (size_t) v * BATCH;
+			for (j = g->off[v]; j < g->off[v + 1]; j++) {
+				w = g->adj[j];
+				if ((nm = m & out[w]) == 0) {
+					continue;
+				}
+				cw = b->coef + (size_t) w * BATCH;
+				for (esum = 0.0, k = 0; k < BATCH; k++) {
+					esum += sv[k] * cw[k] * (double) ((nm >> k) & 1);
+				}
+				edge[epos[j]] += esum;
+			}
+		}
+	}
+	for (e = b->level[1]; e < b->level[2]; e++) {
+		b->at[1][b->ent[e]] = 0;
 	}
-	while (!(TAILQ_EMPTY(p))) {
-		TAILQ_REMOVE(p, TAILQ_FIRST(p), tq_elem);
+
+	/* back to the initial state */
+	for (e = 0; e < nent; e++) {
+		wk = (size_t) b->ent[e] * BATCH;
+		for (k = 0; k < BATCH; k++) {
+			b->sigma[wk + k] = 0.0;
+		}
+		b->seen[b->ent[e]] = 0;
 	}
-	free(p);
-	free(vr);
 }
 
-struct _listelem *
-list_alloc(void)
+/* qsort() helper for component_csr(): key ids of the graph vertices */
+const wg_keyid_t *member_ids;
+
+int
+membercmp(const void *a, const void *b)
 {
-	struct _listelem *elem;
-	if ((elem = (struct _listelem *) malloc(sizeof(struct _listelem))) == NULL) {
-		fprintf(stderr, "malloc failed\n");
-		exit(2);
-	}
-	/* Make sure it's fresh */
-	bzero((void *) elem, sizeof(struct _listelem));
+	keyid_t         x = (keyid_t) member_ids[*(const uint32_t *) a];
+	keyid_t         y = (keyid_t) member_ids[*(const uint32_t *) b];
 
-	return elem;
+	return (x < y) ? -1 : (x > y);
 }
 
-struct _sortelem *
-sort_alloc(void)
+/*
+ * Number the n graph vertices in members by key id and copy the
+ * signatures of g among them into CSR adjacency c and its reverse rc;
+ * vmap gets the component number of every graph vertex, NOT_NUMBERED
+ * outside. Returns the array mapping component numbers to key ids.
+ */
+keyid_t        *
+component_csr(uint32_t * members, uint32_t n, const struct wg_graph * g,
+	      uint32_t * vmap, struct wg_csr * c, struct wg_csr * rc)
 {
-	struct _sortelem *elem;
-	struct listhead *h;
-	if ((elem = (struct _sortelem *) malloc(sizeof(struct _sortelem))) == NULL) {
-		fprintf(stderr, "malloc failed\n");
-		exit(2);
+	keyid_t        *index;
+	struct wg_edges edges;
+	uint32_t        v, src, dst;
+	size_t          i;
+
+	member_ids = g->keys.ids;
+	qsort(members, n, sizeof(uint32_t), membercmp);
+	index = (keyid_t *) wg_malloc(n * sizeof(keyid_t));
+	for (v = 0; v < g->keys.n; v++) {
+		vmap[v] = NOT_NUMBERED;
+	}
+	for (v = 0; v < n; v++) {
+		vmap[members[v]] = v;
+		index[v] = (keyid_t) g->keys.ids[members[v]];
 	}
-	if ((h = (struct listhead *) malloc(sizeof(struct listhead))) == NULL) {
-		fprintf(stderr, "malloc failed\n");
-		exit(2);
+
+	wg_edges_init(&edges);
+	for (i = 0; i < g->sigs.n; i++) {
+		src = vmap[g->sigs.src[i]];
+		dst = vmap[g->sigs.dst[i]];
+		if (src != NOT_NUMBERED && dst != NOT_NUMBERED) {
+			wg_edges_add(&edges, src, dst);
+		}
 	}
-	elem->vertices = h;
+	/* sorted rows make the result independent of the input order */
+	wg_edges_dedup(&edges);
+	wg_csr_build(c, n, &edges, WG_FORWARD);
+	wg_csr_build(rc, n, &edges, WG_REVERSE);
+	wg_edges_free(&edges);
 
-	return elem;
+	return index;
 }
 
-void 
-list_copy(struct listhead * dst_h, struct listhead * src_h)
+/*
+ * Zeroed sums for the graph rg, with or without the edge and
+ * square vectors.
+ */
+void
+sums_alloc(struct brandes_sums * s, const struct wg_csr * rg, int edges, int squares)
 {
-	struct _listelem *s;
-	LIST_FOREACH(s, src_h, sl_elem) {
-		struct _listelem *d;
-		d = list_alloc();
-		d->vert = s->vert;
-		LIST_INSERT_HEAD(dst_h, d, sl_elem);
-	}
-	return;
+	s->centrality = (double *) wg_calloc(rg->n, sizeof(double));
+	s->bridge = (double *) wg_calloc(rg->n, sizeof(double));
+	s->edge = edges ? (double *) wg_calloc(rg->m, sizeof(double)) : NULL;
+	s->sq = squares ? (double *) wg_calloc(rg->n, sizeof(double)) : NULL;
 }
 
-void 
-list_free(struct listhead * l)
+void
+sums_free(struct brandes_sums * s)
 {
-	while (!LIST_EMPTY(l)) {
-		LIST_REMOVE(LIST_FIRST(l), sl_elem);
-	}
-	return;
+	free(s->centrality);
+	free(s->bridge);
+	free(s->edge);
+	free(s->sq);
 }
 
-
+/* to += from, from = 0 */
 void
-enqueue(struct tailqhead * tq_h, struct _vertex * v)
+sums_add(struct brandes_sums * to, struct brandes_sums * from,
+	 const struct wg_csr * rg)
 {
-	struct _listelem *elem;
+	uint32_t        v;
+	size_t          j;
 
-	elem = list_alloc();
-	elem->vert = v;
-	TAILQ_INSERT_TAIL(tq_h, elem, tq_elem);
-	return;
+	for (v = 0; v < rg->n; v++) {
+		to->centrality[v] += from->centrality[v];
+		to->bridge[v] += from->bridge[v];
+		from->centrality[v] = from->bridge[v] = 0.0;
+	}
+	for (j = 0; to->edge != NULL && j < rg->m; j++) {
+		to->edge[j] += from->edge[j];
+		from->edge[j] = 0.0;
+	}
+	for (v = 0; to->sq != NULL && v < rg->n; v++) {
+		to->sq[v] += from->sq[v];
+		from->sq[v] = 0.0;
+	}
 }
 
-struct _vertex *
-dequeue(struct tailqhead * tq_h)
+/* Called with the job lock held */
+void
+progress(struct brandes_job * job)
 {
-	struct _vertex *v;
-	struct _listelem *elem;
+	struct timeval  tvnow;
+	double          perc, todo;
+	int             span, hours, mins, secs;
 
-	if (TAILQ_EMPTY(tq_h)) {
-		return NULL;
+	if (gettimeofday(&tvnow, NULL) != 0) {
+		fprintf(stderr, "Could not get time: %s\n", strerror(errno));
+		exit(1);
 	}
-	elem = TAILQ_FIRST(tq_h);
-	TAILQ_REMOVE(tq_h, elem, tq_elem);
-	v = elem->vert;
-	free(elem);
-	return v;
+	/* Convoluted machinations to get the ETA */
+	span = tvnow.tv_sec - job->start.tv_sec;
+	perc = (double) job->done;
+	perc /= job->nsources;
+	todo = (((double) span) / perc) - (double) span;
+	perc *= 100;
+
+	hours = (int) floor(todo / 3600);
+	todo -= (hours * 3600.0);
+	mins = (int) floor(todo / 60);
+	todo -= (mins * 60.0);
+	secs = (int) floor(todo);
+
+	fprintf(stderr, "%u\tof %u done\t( %.3f %%)\t(ETA %dh%02dm%02ds)\n",
+		job->done, job->nsources, perc, hours, mins, secs);
 }
 
-void
-stack_push(struct listhead * sl_h, struct _vertex * v)
+void           *
+brandes_run(void *arg)
 {
-	struct _listelem *elem;
+	struct brandes_worker *wk = (struct brandes_worker *) arg;
+	struct brandes_job *job = wk->job;
+	struct brandes *b = NULL;
+	struct msbrandes *mb = NULL;
+	uint32_t        s, first, last = 0, n = job->nsources;
+
+	if (batched) {
+		mb = msbrandes_alloc(job->succ);
+	} else {
+		b = brandes_alloc(job->succ);
+	}
+	for (;;) {
+		pthread_mutex_lock(&job->lock);
+		if (last > 0) {
+			/* report the chunk we just finished */
+			if ((job->done + last - first) / 100 > job->done / 100) {
+				job->done += last - first;
+				progress(job);
+			} else {
+				job->done += last - first;
+			}
+		}
+		first = job->next;
+		last = (n - first > CHUNK) ? first + CHUNK : n;
+		job->next = last;
+		pthread_mutex_unlock(&job->lock);
+
+		if (first >= n) {
+			break;
+		}
+		if (batched) {
+			for (s = first; s < last; s += BATCH) {
+				batch_round(job->sources + s,
+				     (last - s > BATCH) ? BATCH : (int) (last - s),
+					    job->succ, mb, &wk->sums, job->epos);
+			}
+		} else {
+			for (s = first; s < last; s++) {
+				vertex_round(job->sources[s], job->succ, job->pred,
+					     job->index, b, &wk->sums);
+			}
+		}
 
-	elem = list_alloc();
-	elem->vert = v;
+		/* add the chunk to out in its turn */
+		pthread_mutex_lock(&job->lock);
+		while (job->nadded != first) {
+			pthread_cond_wait(&job->added, &job->lock);
+		}
+		pthread_mutex_unlock(&job->lock);
+		sums_add(job->out, &wk->sums, job->pred);
+		pthread_mutex_lock(&job->lock);
+		job->nadded = last;
+		pthread_cond_broadcast(&job->added);
+		pthread_mutex_unlock(&job->lock);
+	}
+	if (batched) {
+		msbrandes_free(mb);
+	} else {
+		brandes_free(b);
+	}
+	return NULL;
+}
 
-	LIST_INSERT_HEAD(sl_h, elem, sl_elem);
-	return;
+/*
+ * Position in rg of every edge of g. Both are built from edges sorted
+ * by (signer, signee) (see component_csr()), so the signers of every
+ * row of rg come in increasing order and a cursor per row will do.
+ */
+size_t         *
+edge_positions(const struct wg_csr * g, const struct wg_csr * rg)
+{
+	size_t         *epos, *cursor, j;
+	uint32_t        v;
+
+	epos = (size_t *) wg_malloc(g->m * sizeof(size_t));
+	cursor = (size_t *) wg_malloc(rg->n * sizeof(size_t));
+	memcpy(cursor, rg->off, rg->n * sizeof(size_t));
+	for (v = 0; v < g->n; v++) {
+		for (j = g->off[v]; j < g->off[v + 1]; j++) {
+			epos[j] = cursor[g->adj[j]]++;
+		}
+	}
+	free(cursor);
+	return epos;
 }
 
-struct _vertex *
-stack_pop(struct listhead * sl_h)
+/*
+ * Add the dependencies on the nsources given sources to out, see
+ * struct brandes_sums, with nthreads workers. They are added chunk
+ * by chunk in the order of sources (see struct brandes_job), so the
+ * output does not depend on nthreads or on the scheduler.
+ */
+void
+betweenness(const struct wg_csr * g, const struct wg_csr * rg, const keyid_t * index,
+	    const uint32_t * sources, uint32_t nsources, int nthreads,
+	    struct brandes_sums * out)
 {
-	struct _listelem *elem;
-	struct _vertex *v;
+	struct brandes_job job;
+	struct brandes_worker *wk;
+	int             t;
+
+	job.succ = g;
+	job.pred = rg;
+	job.index = index;
+	job.sources = sources;
+	job.nsources = nsources;
+	job.epos = (out->edge != NULL && batched) ? edge_positions(g, rg) : NULL;
+	job.out = out;
+	job.next = 0;
+	job.nadded = 0;
+	job.done = 0;
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.added, NULL);
+	if (gettimeofday(&job.start, NULL) != 0) {
+		fprintf(stderr, "Could not get time: %s\n", strerror(errno));
+		exit(1);
+	}
 
-	if (LIST_EMPTY(sl_h)) {
-		return NULL;
+	wk = (struct brandes_worker *) wg_malloc(nthreads * sizeof(struct brandes_worker));
+	for (t = 0; t < nthreads; t++) {
+		wk[t].job = &job;
+		sums_alloc(&wk[t].sums, rg, out->edge != NULL, out->sq != NULL);
+		if (nthreads > 1 &&
+		    pthread_create(&wk[t].thread, NULL, brandes_run, &wk[t]) != 0) {
+			fprintf(stderr, "Could not start thread: %s\n", strerror(errno));
+			exit(1);
+		}
+	}
+	if (nthreads == 1) {
+		brandes_run(&wk[0]);
+	}
+	for (t = 0; t < nthreads; t++) {
+		if (nthreads > 1) {
+			pthread_join(wk[t].thread, NULL);
+		}
+		sums_free(&wk[t].sums);
 	}
-	elem = LIST_FIRST(sl_h);
-	v = elem->vert;
-	LIST_REMOVE(elem, sl_elem);
-	free(elem);
-	return v;
+	free(wk);
+	free((void *) job.epos);
+	pthread_mutex_destroy(&job.lock);
+	pthread_cond_destroy(&job.added);
 }
 
-/* Comparison functions for the two types of trees */
+struct twohop_job {
+	const struct wg_twohop *t;
+	double         *size;
+	pthread_mutex_t lock;
+	uint32_t        next;
+};
 
-int
-vertcmp(struct _vertex * a, struct _vertex * b)
+void           *
+twohop_run(void *arg)
 {
-	return (memcmp(((vertex) a)->id, ((vertex) b)->id, idlen));
+	struct twohop_job *job = (struct twohop_job *) arg;
+	struct wg_twohop_scratch s;
+	uint32_t        first, last, n = job->t->g->n;
+
+	wg_twohop_scratch_init(&s, job->t);
+	for (;;) {
+		pthread_mutex_lock(&job->lock);
+		first = job->next;
+		last = (n - first > TWOHOP_CHUNK) ? first + TWOHOP_CHUNK : n;
+		job->next = last;
+		pthread_mutex_unlock(&job->lock);
+
+		if (first >= n) {
+			break;
+		}
+		wg_twohop_count(job->t, &s, first, last, job->size);
+	}
+	wg_twohop_scratch_free(&s);
+	return NULL;
 }
 
-int
-sortcmp(struct _sortelem * a, struct _sortelem * b)
+/*
+ * Size of the two-hop island of every vertex of g: the keys it
+ * reaches over one or two signatures. Hubs, see wg_twohop_init(),
+ * are estimated. Every vertex is written by exactly one worker, so
+ * the result does not depend on nthreads.
+ */
+void
+twohop(const struct wg_csr * g, int nthreads, double *size)
 {
-	if (a->centrality == b->centrality) {
-		return 0;
+	struct wg_twohop t;
+	struct twohop_job job;
+	pthread_t      *thr;
+	int             i;
+
+	wg_twohop_init(&t, g, hubwork);
+	if (t.nhubs > 0) {
+		fprintf(stderr, "Estimating the islands of %u hub keys\n", t.nhubs);
 	}
-	if (a->centrality < b->centrality) {
-		return -1;
-	} else {
-		return 1;
+	job.t = &t;
+	job.size = size;
+	job.next = 0;
+	pthread_mutex_init(&job.lock, NULL);
+
+	thr = (pthread_t *) wg_malloc(nthreads * sizeof(pthread_t));
+	for (i = 1; i < nthreads; i++) {
+		if (pthread_create(&thr[i], NULL, twohop_run, &job) != 0) {
+			fprintf(stderr, "Could not start thread: %s\n", strerror(errno));
+			exit(1);
+		}
 	}
-	/* quartum non datur */
+	twohop_run(&job);
+	for (i = 1; i < nthreads; i++) {
+		pthread_join(thr[i], NULL);
+	}
+	free(thr);
+	pthread_mutex_destroy(&job.lock);
+	wg_twohop_free(&t);
 }
 
+const double   *edge_score;
 
-RB_GENERATE(node_tree, _vertex, nnode, vertcmp);
-RB_GENERATE(sort_tree, _sortelem, snode, sortcmp);
+int
+edgecmp(const void *a, const void *b)
+{
+	size_t          i = *(const size_t *) a, j = *(const size_t *) b;
 
-vertex
-newnode(char *id)
+	if (edge_score[i] != edge_score[j]) {
+		return (edge_score[i] > edge_score[j]) ? -1 : 1;
+	}
+	return (i < j) ? -1 : (i > j);
+}
+
+/*
+ * Write the edge betweenness of every signature to EDGEFILE as
+ * signer;signee;centrality lines, highest first. Ties are in the
+ * order of rg, that is by signee, then signer.
+ */
+void
+write_edges(const struct wg_csr * rg, const keyid_t * index, const double *edge)
 {
-	vertex          new;
-	struct listhead *shead, *phead;
+	FILE           *fp;
+	size_t         *order, j;
+	uint32_t        w, *signee;
 
-	if ((new = (vertex) malloc(sizeof(struct _vertex))) == NULL) {
-		fprintf(stderr, "no malloc\n");
+	if ((fp = fopen(EDGEFILE, "w")) == NULL) {
+		fprintf(stderr, "Could not write to %s\n", EDGEFILE);
 		exit(1);
 	}
-	if ((shead = (struct listhead *) malloc(sizeof(struct listhead))) == NULL) {
-		fprintf(stderr, "no malloc\n");
-		exit(1);
+	signee = (uint32_t *) wg_malloc(rg->m * sizeof(uint32_t));
+	order = (size_t *) wg_malloc(rg->m * sizeof(size_t));
+	for (w = 0; w < rg->n; w++) {
+		for (j = rg->off[w]; j < rg->off[w + 1]; j++) {
+			signee[j] = w;
+		}
 	}
-	if ((phead = (struct listhead *) malloc(sizeof(struct listhead))) == NULL) {
-		fprintf(stderr, "no malloc\n");
-		exit(1);
+	for (j = 0; j < rg->m; j++) {
+		order[j] = j;
+	}
+	edge_score = edge;
+	qsort(order, rg->m, sizeof(size_t), edgecmp);
+	for (j = 0; j < rg->m; j++) {
+		fprintf(fp, KEYFMT ";" KEYFMT ";%.9f\n",
+			idlen, index[rg->adj[order[j]]],
+			idlen, index[signee[order[j]]], edge[order[j]]);
+	}
+	fclose(fp);
+	free(order);
+	free(signee);
+}
+
+/*
+ * Number of sources to sample for approximate betweenness, after
+ * Brandes and Pich, "Centrality Estimation in Large Networks", 2007.
+ * The estimate is n / k times the dependencies summed over k sources
+ * (see main), i.e. n times their mean. One dependency lies in
+ * [0, n - 2], so by Hoeffding's inequality and a union bound over all
+ * n vertices the mean is within t * (n - 2) of its expectation for
+ * every vertex with probability at least 1 - delta once
+ * k >= ln(2n / delta) / (2 t^2). With t = eps * (n - 1) / n every
+ * betweenness is then right to within eps * (n - 1) * (n - 2).
+ */
+uint32_t
+sample_size(uint32_t n, double eps, double delta)
+{
+	double          k, t;
+
+	t = eps * (n - 1.0) / n;
+	k = ceil(log(2.0 * n / delta) / (2.0 * t * t));
+	return (k < n) ? (uint32_t) k : n;
+}
+
+/*
+ * The first k entries of the returned array are a uniform sample of
+ * 0 .. n-1 (partial Fisher-Yates shuffle). With k == n it is simply
+ * all vertices in order.
+ */
+uint32_t       *
+sample_sources(uint32_t n, uint32_t k)
+{
+	uint32_t       *src, i, j, tmp;
+
+	src = (uint32_t *) wg_malloc(n * sizeof(uint32_t));
+	for (i = 0; i < n; i++) {
+		src[i] = i;
 	}
-	LIST_INIT(shead);
-	LIST_INIT(phead);
-	new->successors = shead;
-	new->predecessors = phead;
-	new->id = strdup(id);
-	new->centrality = 0.0;
-	new->d = 0.0;
-	return new;
+	if (k < n) {
+		for (i = 0; i < k; i++) {
+			j = i + (uint32_t) (random() % (n - i));
+			tmp = src[i];
+			src[i] = src[j];
+			src[j] = tmp;
+		}
+	}
+	return src;
 }
 
-/* Adds a successor u to v and a precessor v to u */
 void
-add_neigh(vertex v, vertex u)
-{
-	struct _listelem *e, *d, *tmp;
-	int jump_flag = 0;
-	e = list_alloc();
-	d = list_alloc();
-	e->vert = u;
-	d->vert = v;
-	if (debug) {
-		fprintf(stderr, "adding successor %s to %s\n", u->id, v->id);
+usage(void)
+{
+	fprintf(stderr, "usage: wot [-2bdDemrs] [-c file] [-k num] [-K file] [-n num] [-a eps] [-p delta] [-S seed] [-t num] [-H num] [-j num] [-l num] [file]\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "\t-b\ttraverse from %d sources at once (faster, but\n", BATCH);
+	fprintf(stderr, "\t\tthe last digits may differ)\n");
+	fprintf(stderr, "\t-d\tdebuging output on\n");
+	fprintf(stderr, "\t-D\trank by degree instead of betweenness\n");
+	fprintf(stderr, "\t-n num\tonly print the num most central keys\n");
+	fprintf(stderr, "\t-r\tprint the most central keys first\n");
+	fprintf(stderr, "\t-t num\tapproximate ranking of the num most central keys,\n");
+	fprintf(stderr, "\t\tsampling until they stand apart (see -a, -p); keys\n");
+	fprintf(stderr, "\t\tcloser than eps (-a) or, without -a, 20%% of the\n");
+	fprintf(stderr, "\t\tnum-th may be swapped or traded across the cut\n");
+	fprintf(stderr, "\t-e\talso write the betweenness of every signature to %s\n", EDGEFILE);
+	fprintf(stderr, "\t-2\trank by the number of keys reachable over at most\n");
+	fprintf(stderr, "\t\ttwo signatures instead of betweenness\n");
+	fprintf(stderr, "\t-H num\twith -2, estimate keys whose count would look at\n");
+	fprintf(stderr, "\t\tmore than num signatures (default %d, 0: never)\n", HUBWORK);
+	fprintf(stderr, "\t-m\tdump the biggest component to %s\n", COMPFILE);
+	fprintf(stderr, "\t-s\tfile is strongly connected already (preprocessed.strongset)\n");
+	fprintf(stderr, "\t-c file\ttake the component from file's \"keyid;label\" lines\n");
+	fprintf(stderr, "\t\t(keyanalyze's othersets.txt)\n");
+	fprintf(stderr, "\t-k num\tcut the num top ranked keys one by one, write the\n");
+	fprintf(stderr, "\t\tislands each cut leaves to %s\n", ISLANDFILE);
+	fprintf(stderr, "\t-K file\tcut the keys listed in file instead, e.g. by MSD:\n");
+	fprintf(stderr, "\t\tsort -t';' -k2 -n msd.csv | cut -d';' -f1\n");
+	fprintf(stderr, "\t-a eps\testimate betweenness by sampling sources, with\n");
+	fprintf(stderr, "\t\terrors below eps * (n-1)(n-2) (0 < eps < 1)\n");
+	fprintf(stderr, "\t-p delta\twith probability 1 - delta (default 0.1)\n");
+	fprintf(stderr, "\t-S seed\tseed of the source sampling (default 1)\n");
+	fprintf(stderr, "\t-j num\tuse num threads for the betweenness\n");
+	fprintf(stderr, "\t-l num\tids are num chars long\n");
+	fprintf(stderr, "\n\tWithout file or with file \"-\", read stdin.\n");
+	exit(1);
+}
+
+/*
+ * Put the graph vertices of the largest strongly connected component
+ * of the signature graph into members (Tarjan's algorithm, see
+ * wg_scc()). Returns its size.
+ */
+int
+find_biggest_compound(const struct wg_graph * g, uint32_t * members)
+{
+	struct wg_csr   csr;
+	struct wg_scc   scc;
+	uint32_t        c;
+	size_t          size;
+
+	wg_csr_build(&csr, g->keys.n, &g->sigs, WG_FORWARD);
+	wg_scc(&csr, &scc);
+	for (c = 0; c < scc.ncomp; c++) {
+		if (scc.off[c + 1] - scc.off[c] > (size_t) 100) {
+			fprintf(stderr, "Interesting component with %lu members containing " KEYFMT "\n",
+				(unsigned long) (scc.off[c + 1] - scc.off[c]), idlen,
+				(keyid_t) g->keys.ids[scc.root[c]]);
+		}
 	}
-	/* Check if the link is already there */
-	LIST_FOREACH(tmp, v->successors, sl_elem) {
-		if (bcmp(tmp->vert->id, e->vert->id, idlen) == 0) {
-			jump_flag++;
-			break;
+	size = scc.off[scc.giant + 1] - scc.off[scc.giant];
+	memcpy(members, scc.members + scc.off[scc.giant], size * sizeof(uint32_t));
+	wg_scc_free(&scc);
+	wg_csr_free(&csr);
+	return size;
+}
+
+/*
+ * Read strongly connected component labels, one "<keyid>;<label>"
+ * line per key as in keyanalyze's othersets.txt, and put the keys
+ * carrying the most frequent label into members. Keys not in the
+ * graph are ignored.
+ */
+int
+read_components(const char *fname, const struct wg_graph * g, uint32_t * members)
+{
+	FILE           *fp;
+	char            line[1024], *p;
+	struct wg_idtab labels;
+	uint32_t       *label, *count, best = 0;
+	wg_keyid_t      id;
+	int64_t         v;
+	int             c = 0;
+
+	if ((fp = fopen(fname, "r")) == NULL) {
+		fprintf(stderr, "Error opening %s: %s\n", fname, strerror(errno));
+		exit(1);
+	}
+	wg_idtab_init(&labels);
+	label = (uint32_t *) wg_malloc(g->keys.n * sizeof(uint32_t));
+	for (v = 0; v < g->keys.n; v++) {
+		label[v] = UINT32_MAX;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		if (wg_keyid_parse(line, idlen, &id) != 0 ||
+		    (p = strchr(line, ';')) == NULL) {
+			continue;
+		}
+		if ((v = wg_idtab_find(&g->keys, id)) < 0) {
+			continue;
 		}
+		label[v] = wg_idtab_intern(&labels, strtoull(p + 1, NULL, 10));
 	}
-	if (!jump_flag) {
-		LIST_INSERT_HEAD(v->successors, e, sl_elem);
+	if (ferror(fp)) {
+		fprintf(stderr, "Error reading %s: %s\n", fname, strerror(errno));
+		exit(1);
 	}
-	/* To be on the safe side, check the reverse too */
-	jump_flag=0;
-	LIST_FOREACH(tmp, u->predecessors, sl_elem) {
-		if (bcmp(tmp->vert->id, d->vert->id, idlen) == 0) {
-			jump_flag++;
-			break;
+	fclose(fp);
+
+	count = (uint32_t *) wg_calloc(labels.n, sizeof(uint32_t));
+	for (v = 0; v < g->keys.n; v++) {
+		if (label[v] != UINT32_MAX && ++count[label[v]] > count[best]) {
+			best = label[v];
 		}
 	}
-	if (!jump_flag) {
-		LIST_INSERT_HEAD(u->predecessors, d, sl_elem);
+	for (v = 0; v < g->keys.n; v++) {
+		if (label[v] == best && labels.n > 0) {
+			members[c++] = v;
+		}
 	}
-	return;
+	free(count);
+	free(label);
+	wg_idtab_free(&labels);
+	return c;
 }
 
-
 /*
- * vertex_round
- * 
- * round-function to be called for each vertex of the graph. updates the
- * centrality of vertices on every shortest path from the given vertex to
- * every other.
- * 
- * Algorithm was presented by Ulrik Brandes in "A Faster Algorithm for
- * Betweennes Centrality" in "Journal of Mathematical Sociology",
- * 25(5):163-177, 2001.
- * 
- * Earlier implementations used a modified Floyd-Warshall, and were way
- * too slow.
+ * The ranking that is printed: (score, number) pairs, higher score
+ * first, then lower number, so the first pair is the most central
+ * vertex. cut_order() ranks the same way.
  */
+struct rank {
+	double          score;
+	uint32_t        num;
+};
 
-void
-vertex_round(vertex s, struct node_tree * nhead)
+int
+rankcmp(const void *a, const void *b)
 {
-	vertex          fnode, v, w;
-	int             stack_count = 0;
-	int             neighbor_count = 0;
-
-	struct listhead stack_head;
-	struct tailqhead q_head;
-	struct listhead *h;
-	struct _listelem *e;
+	const struct rank *x = a, *y = b;
 
-	LIST_INIT(&stack_head);
-	TAILQ_INIT(&q_head);
-
-	/* Reset the per-vertex auxillary variables */
-	RB_FOREACH(fnode, node_tree, nhead) {
-		vr_free((struct vr_attr *) fnode->attribs[VR]);
-		fnode->attribs[VR] = (void *) vr_alloc();
-		fnode->d = -1.0;
+	if (x->score != y->score) {
+		return (x->score > y->score) ? -1 : 1;
 	}
+	return (x->num < y->num) ? -1 : (x->num > y->num);
+}
 
-	((struct vr_attr *) s->attribs[VR])->sigma = 1.0;
-	s->d = 0.0;
+/* One run of rank_sort(), sorted by its own thread */
+struct rank_run {
+	struct rank    *r;
+	size_t          n;
+	pthread_t       thread;
+};
 
-	enqueue(&q_head, s);
+/* runs shorter than this are not worth a thread */
+#define RANK_MINRUN 4096
 
-	if (debug) {
-		fprintf(stderr, "working on %s: \n ", s->id);
-	}
-	while ( (v = dequeue(&q_head)) ) {
+void           *
+rank_run_sort(void *arg)
+{
+	struct rank_run *run = arg;
 
-		stack_push(&stack_head, v);
-		stack_count++;
+	qsort(run->r, run->n, sizeof(struct rank), rankcmp);
+	return NULL;
+}
 
-		/* iterate over the neighbors */
-		h = v->successors;
-		neighbor_count = 0;
+/*
+ * Sort r in place with up to nthreads threads: every thread sorts one
+ * run, then the runs are merged pairwise through a scratch array.
+ */
+void
+rank_sort(struct rank * r, size_t n, int nthreads)
+{
+	struct rank_run *runs;
+	struct rank    *tmp, *from, *to, *t;
+	size_t          nruns, i, j, k, a, b, start, aend, end;
+	int             err;
+
+	nruns = n / RANK_MINRUN + 1;
+	if (nruns > (size_t) nthreads) {
+		nruns = nthreads;
+	}
+	if (nruns == 1) {
+		qsort(r, n, sizeof(struct rank), rankcmp);
+		return;
+	}
+	runs = (struct rank_run *) wg_malloc(nruns * sizeof(struct rank_run));
+	for (i = 0; i < nruns; i++) {
+		runs[i].r = r + n * i / nruns;
+		runs[i].n = n * (i + 1) / nruns - n * i / nruns;
+	}
+	for (i = 1; i < nruns; i++) {
+		if ((err = pthread_create(&runs[i].thread, NULL, rank_run_sort, &runs[i])) != 0) {
+			fprintf(stderr, "pthread_create: %s\n", strerror(err));
+			exit(2);
+		}
+	}
+	rank_run_sort(&runs[0]);
+	for (i = 1; i < nruns; i++) {
+		pthread_join(runs[i].thread, NULL);
+	}
 
-		if (debug) {
-			fprintf(stderr, "Neighbors of %s: \n", v->id);
-		}
-		if (!LIST_EMPTY(h)) {
-			e = LIST_FIRST(h);
-			do {
-				w = e->vert;
-				neighbor_count++;
-				if (debug) {
-					fprintf(stderr, "%s,", w->id);
-				}
-				/* Seen the first time? */
-				if (w->d < 0) {
-					enqueue(&q_head, w);
-					w->d = v->d + 1.0;
-				}
-				/* On shortest path to w via v? */
-				/* XXX_nagging_doubt the right direction? */
-				if (w->d == (v->d + 1.0)) {
-					((struct vr_attr *) w->attribs[VR])->sigma +=
-						((struct vr_attr *) v->attribs[VR])->sigma;
-					/* append to list P[w] */
-					enqueue(((struct vr_attr *) w->attribs[VR])->P, v);
-				}
-			} while ((e = LIST_NEXT(e, sl_elem)));
-			if (debug) {
-				fprintf(stderr, "\n");
+	/* merge neighbouring runs until one is left */
+	tmp = (struct rank *) wg_malloc(n * sizeof(struct rank));
+	from = r;
+	to = tmp;
+	while (nruns > 1) {
+		for (i = 0, j = 0; i < nruns; i += 2, j++) {
+			a = start = runs[i].r - r;
+			b = aend = end = a + runs[i].n;
+			if (i + 1 < nruns) {
+				end += runs[i + 1].n;
 			}
+			for (k = a; a < aend && b < end; k++) {
+				to[k] = (rankcmp(&from[b], &from[a]) < 0) ?
+					from[b++] : from[a++];
+			}
+			memcpy(to + k, from + a, (aend - a) * sizeof(struct rank));
+			k += aend - a;
+			memcpy(to + k, from + b, (end - b) * sizeof(struct rank));
+			runs[j].r = r + start;
+			runs[j].n = end - start;
 		}
-		if (debug) {
-			fprintf(stderr, "\t%s has %d neighbors\n", v->id, neighbor_count);
-		}
+		nruns = j;
+		t = from;
+		from = to;
+		to = t;
 	}
-
-	if (debug) {
-		fprintf(stderr, "Stackheight %d\n", stack_count);
+	if (from != r) {
+		memcpy(r, from, n * sizeof(struct rank));
 	}
-	while ((w = stack_pop(&stack_head))) {
-		vertex          v;
+	free(tmp);
+	free(runs);
+}
 
-		if (debug) {
-			fprintf(stderr, "\tStack %s\n", w->id);
+/*
+ * Partial selection (Hoare's quickselect): reorder r so that its first
+ * k pairs are the k most central ones, in no particular order.
+ */
+void
+rank_select(struct rank * r, size_t n, size_t k)
+{
+	struct rank     p, t;
+	size_t          lo = 0, hi = n, i, j, m;
+
+	while (lo < k && k < hi) {
+		/* median of three as the pivot, moved to r[lo] */
+		m = lo + (hi - lo) / 2;
+		if (rankcmp(&r[m], &r[lo]) < 0) {
+			t = r[m], r[m] = r[lo], r[lo] = t;
+		}
+		if (rankcmp(&r[hi - 1], &r[m]) < 0) {
+			t = r[hi - 1], r[hi - 1] = r[m], r[m] = t;
+			if (rankcmp(&r[m], &r[lo]) < 0) {
+				t = r[m], r[m] = r[lo], r[lo] = t;
+			}
 		}
-		/* go through P[w] */
-		if (!TAILQ_EMPTY(((struct vr_attr *) w->attribs[VR])->P)) {
-			while ((v = dequeue(((struct vr_attr *) w->attribs[VR])->P))) {
-				double          ftmp;
+		t = r[m], r[m] = r[lo], r[lo] = t;
+		p = r[lo];
 
-				if (debug) {
-					fprintf(stderr, "\t\tList %s\n", v->id);
-				}
-				ftmp = ((struct vr_attr *) v->attribs[VR])->delta +
-					(((struct vr_attr *) v->attribs[VR])->sigma /
-				((struct vr_attr *) w->attribs[VR])->sigma) *
-					(1.0 +
-					 (((struct vr_attr *) w->attribs[VR])->delta));
-
-				/*
-				 * Did something go _terribly_, numerically
-				 * wrong?
-				 */
-				if (isinf(ftmp) || isnan(ftmp)) {
-					fprintf(stderr, " %s->delta= %f\t %s->sigma= %f \t %s->sigma=%f \t %s->delta=%f\n",
-						v->id,
-						((struct vr_attr *) v->attribs[VR])->delta,
-						v->id,
-						((struct vr_attr *) v->attribs[VR])->sigma,
-						w->id,
-						((struct vr_attr *) w->attribs[VR])->sigma,
-						w->id,
-						((struct vr_attr *) w->attribs[VR])->delta);
-					/* force core-dump */
-					kill(getpid(), SIGSEGV);
-				}
-				((struct vr_attr *) v->attribs[VR])->delta = ftmp;
+		/* r[lo..j] come before r[j+1..hi-1] */
+		for (i = lo, j = hi - 1;;) {
+			while (rankcmp(&r[i], &p) < 0) {
+				i++;
+			}
+			while (rankcmp(&r[j], &p) > 0) {
+				j--;
 			}
+			if (i >= j) {
+				break;
+			}
+			t = r[i], r[i] = r[j], r[j] = t;
+			i++;
+			j--;
 		}
-		if (w != s) {
-			w->centrality += ((struct vr_attr *) w->attribs[VR])->delta;
+		if (k <= j) {
+			hi = j + 1;
+		} else {
+			lo = j + 1;
 		}
 	}
 }
 
-void
-usage(void)
+/*
+ * The k vertices with the highest score, best first: rank_select()
+ * picks them, only those k are sorted.
+ */
+uint32_t       *
+cut_order(const double *score, uint32_t n, uint32_t k)
 {
-	fprintf(stderr, "usage: wot [-dm] [-l num] file\n");
-	fprintf(stderr, "\n");
-	fprintf(stderr, "\t-d\tdebuging output on\n");
-	fprintf(stderr, "\t-m\tdump the biggest component to %s\n", COMPFILE);
-	fprintf(stderr, "\t-l num\tids are num chars long\n");
-	exit(1);
+	struct rank    *r;
+	uint32_t       *order, v;
+
+	r = (struct rank *) wg_malloc(n * sizeof(struct rank));
+	for (v = 0; v < n; v++) {
+		r[v].score = score[v];
+		r[v].num = v;
+	}
+	rank_select(r, n, k);
+	qsort(r, k, sizeof(struct rank), rankcmp);
+	order = (uint32_t *) wg_malloc(k * sizeof(uint32_t));
+	for (v = 0; v < k; v++) {
+		order[v] = r[v].num;
+	}
+	free(r);
+	return order;
 }
 
 /*
- * component_round
- *
- * Given a starting vertex s, a copy of the graph as RB_TREE
- * with root nhead, it removes the component containing s from
- * the graph and puts the component's vertices (with
- * successor/predecessor  lists) in a list given as parameter.
+ * Print "keyid;centrality;bridge" lines, least central first as ever
+ * or most central first with -r. With ntop > 0 only the ntop most
+ * central keys are selected and sorted.
  */
-int
-component_round(vertex s, struct node_tree * nhead, struct listhead * list)
+void
+print_ranking(const keyid_t * index, const double *centrality, const double *bridge,
+	      uint32_t n, uint32_t ntop)
 {
-	vertex          fnode, v;
-	int             count = 0;
+	struct rank    *r;
+	uint32_t        v, i;
 
-	struct tailqhead q_head;
-	struct _listelem *e, *n;
-
-	TAILQ_INIT(&q_head);
-	RB_FOREACH(fnode, node_tree, nhead) {
-		fnode->d = 0;
+	r = (struct rank *) wg_malloc(n * sizeof(struct rank));
+	for (v = 0; v < n; v++) {
+		r[v].score = centrality[v];
+		r[v].num = v;
 	}
+	if (ntop == 0 || ntop > n) {
+		ntop = n;
+	}
+	if (ntop < n) {
+		rank_select(r, n, ntop);
+	}
+	rank_sort(r, ntop, nthreads);
+	for (i = 0; i < ntop; i++) {
+		v = r[reverseflag ? i : ntop - 1 - i].num;
+		printf(KEYFMT ";%.9f;%.9f\n", idlen, index[v],
+		       centrality[v], bridge[v]);
+	}
+	free(r);
+}
 
-	s->d = 1.0;
-
-	enqueue(&q_head, s);
-
-	while ((v = dequeue(&q_head))) {
-		e = list_alloc();
-		e->vert = v;
-		LIST_INSERT_HEAD(list, e, sl_elem);
-		LIST_FOREACH(n, v->successors, sl_elem) {
-			/* been there ? */
-			if (n->vert->d != 1.0) {
-				n->vert->d = 1.0;
-				enqueue(&q_head, n->vert);
-				count++;
+/*
+ * -t k, k < n: approximate betweenness of the k most central vertices
+ * by adaptive sampling. Sources are taken from a random permutation in rounds of
+ * doubling size. After each round every vertex gets a confidence
+ * interval around its mean dependency on one source from the sample
+ * variance, a normal approximation corrected for sampling without
+ * replacement, so it shrinks to nothing as the sample grows to all n
+ * sources. (Worst case bounds such as empirical Bernstein carry a
+ * term (n - 2) / k, the range of one dependency, that keeps keys of
+ * little centrality from ever being ruled out before k nears n.)
+ *
+ * Sampling stops once every interval is clear of the line between
+ * the k-th and the k+1-th estimate and the top k intervals are clear
+ * of each other, so that with probability about 1 - delta (-p) both
+ * the set and its order are right. As in KADABRA (Borassi and
+ * Natale, 2016) intervals narrower than eps * (n - 1)(n - 2) (-a)
+ * count as clear. Without -a the tolerance is TOPK_TOL times the k-th
+ * estimate instead: near ties never separate, and requiring them to
+ * would take all n sources. So unless the sample grows to all n
+ * sources, keys closer than the tolerance may be swapped, or the last
+ * of the top k traded for the first key left out; how many were too
+ * close to call is reported.
+ *
+ * The sums over the sources used are left in out, and their number
+ * is returned.
+ */
+uint32_t
+topk_sample(const struct wg_csr * g, const struct wg_csr * rg, const keyid_t * index,
+	    uint32_t k, struct brandes_sums * out)
+{
+	uint32_t        n = g->n, *sources, *order, done = 0, next, rounds, i;
+	uint32_t        unsure, unordered, close = 0;
+	double         *mu, *r, z, var, rho, tol, line;
+
+	/* n - 1 swaps already shuffle all of them */
+	sources = sample_sources(n, n > 1 ? n - 1 : n);
+	mu = (double *) wg_malloc(n * sizeof(double));
+	r = (double *) wg_malloc(n * sizeof(double));
+	next = (n > TOPK_FIRST) ? TOPK_FIRST : n;
+	for (rounds = 1; ((uint64_t) next << (rounds - 1)) < n; rounds++);
+
+	/* normal quantile for a union bound over vertices and rounds */
+	z = sqrt(2.0 * log(2.0 * n * rounds / delta));
+
+	for (;;) {
+		betweenness(g, rg, index, sources + done, next - done, nthreads, out);
+		done = next;
+		if (done == n) {
+			close = 0;
+			break;
+		}
+		rho = (n - done) / (n - 1.0);
+		for (i = 0; i < n; i++) {
+			mu[i] = out->centrality[i] / done;
+			var = (out->sq[i] / done - mu[i] * mu[i]) * done / (done - 1.0);
+			r[i] = z * sqrt((var > 0.0 ? var : 0.0) * rho / done);
+		}
+		order = cut_order(mu, n, k + 1);
+		tol = (epsilon > 0.0) ? epsilon * (n - 1.0) * (n - 2.0) / n :
+			TOPK_TOL * mu[order[k - 1]];
+
+		/* the top k against the rest */
+		line = (mu[order[k - 1]] + mu[order[k]]) / 2.0;
+		for (unsure = close = 0, i = 0; i < n; i++) {
+			if (mu[i] - r[i] <= line && mu[i] + r[i] >= line) {
+				if (r[i] > tol) {
+					unsure++;
+				} else {
+					close++;
+				}
 			}
 		}
- /* only check forward. assure that the initial node _is_ in the strong component */
-#if 0
-		LIST_FOREACH(n, v->predecessors, sl_elem) {
-			/* been there ? */
-			if (n->vert->d != 1.0) {
-				n->vert->d = 1.0;
-				enqueue(&q_head, n->vert);
-				count++;
+
+		/* and among each other */
+		for (unordered = 0, i = 0; i + 1 < k; i++) {
+			if (mu[order[i]] - r[order[i]] <= mu[order[i + 1]] + r[order[i + 1]]) {
+				if (r[order[i]] > tol || r[order[i + 1]] > tol) {
+					unordered++;
+				} else {
+					close++;
+				}
 			}
 		}
-#endif /* 0 */
-		RB_REMOVE(node_tree, nhead, v);
+		free(order);
+		fprintf(stderr, "%u sources: %u keys not clearly in or out of the top %u, "
+			"%u of its neighbours not in order\n", done, unsure, k, unordered);
+		if (unsure == 0 && unordered == 0) {
+			break;
+		}
+		next = (n - done > done) ? 2 * done : n;
+	}
+	if (close > 0) {
+		fprintf(stderr, "The top %u is approximate: %u keys at the cut or "
+			"pairs in it were too close to call\n", k, close);
 	}
-	return count;
+	free(mu);
+	free(r);
+	free(sources);
+	return done;
 }
 
 /*
- * find the largest connected component in a graph. If dumpflag
- * is set, dump component in file COMPFILE.
+ * Read the cut order from fname, one key id per line, first line
+ * first. Ids not in the component (NOT_NUMBERED in vmap) and repeats
+ * are skipped. Returns the number of keys put into order.
  */
-int
-find_biggest_compound(struct node_tree * allkeys, struct node_tree * result)
+uint32_t
+read_cut_order(const char *fname, const uint32_t * vmap, const struct wg_graph * g,
+	       uint32_t * order, uint32_t max)
 {
-	int             max = 0;
-	int             c;
-	struct listhead l, maxlist;
-	struct _listelem *e;
-	vertex          s;
-	FILE           *maxcomp = NULL;
-
-	LIST_INIT(&l);
-	LIST_INIT(&maxlist);
+	FILE           *fp;
+	char            line[1024];
+	wg_keyid_t      id;
+	int64_t         v;
+	uint32_t        k = 0, i;
 
-	/*
-	 * XXX The first component with more than 100000 vertices is
-	 * returned.
-	 */
-		while ((!RB_EMPTY(allkeys)) && max < 100000) {
-		int             num;
-		/* pick vertex with smallest id */
-		s = RB_MIN(node_tree, allkeys);
-		/* cut out the component containing s */
-		num = component_round(s, allkeys, &l);
-		if (num > 100) {
-			fprintf(stderr, "Interesting component with %d members containing %s\n", num, s->id);
-		}
-		if (num > max) {
-			max = num;
-			fprintf(stderr, "New maximum component (%d nodes)\n", max);
-			/* XXX This is inefficient */
-			list_free(&maxlist);
-			list_copy(&maxlist, &l);
-		}
-		list_free(&l);
+	if ((fp = fopen(fname, "r")) == NULL) {
+		fprintf(stderr, "Error opening %s: %s\n", fname, strerror(errno));
+		exit(1);
 	}
-	if (dumpflag) {
-		if ((maxcomp = fopen(COMPFILE, "w+")) == NULL) {
-			fprintf(stderr, "Could not write to %s\n", COMPFILE);
-			exit(1);
+	while (k < max && fgets(line, sizeof(line), fp)) {
+		if (wg_keyid_parse(line, idlen, &id) != 0 ||
+		    (v = wg_idtab_find(&g->keys, id)) < 0 ||
+		    vmap[v] == NOT_NUMBERED) {
+			continue;
+		}
+		for (i = 0; i < k && order[i] != vmap[v]; i++);
+		if (i == k) {
+			order[k++] = vmap[v];
 		}
 	}
-	c = 0;
-	LIST_FOREACH(e, &maxlist, sl_elem) {
-		struct _listelem *el;
+	fclose(fp);
+	return k;
+}
+
+/*
+ * Cut the keys order[0], order[1], ... order[k-1] out of the component
+ * one after the other and write to ISLANDFILE which islands each cut
+ * separates from the largest remaining part:
+ *
+ *	c<cut>;<keyid>;<size of the largest part after the cut>
+ *	i<size>;<keyid> <keyid> ...
+ *
+ * Connectivity ignores the direction of signatures. Instead of
+ * searching the graph after every cut, the keys are put back in
+ * reverse order into a union-find structure: the parts a key joins
+ * when it comes back are the parts its removal split its part into.
+ * That is O(m) for all k cuts together, plus the size of the output.
+ */
+void
+cut_islands(const struct wg_csr * g, const struct wg_csr * rg, const keyid_t * index,
+	    const uint32_t * order, uint32_t k)
+{
+	struct wg_uf    uf;
+	uint32_t       *gone, *mark, *first, *last, *next, *parts, *giant;
+	uint32_t       *mem, *isize, *ifirst, nisl = 0, icap = 1024;
+	size_t          nmem = 0, mcap = 1024, e, *istart;
+	uint32_t        v, w, r, x, big, maxsize = 0, merged, np, step, i;
+	const struct wg_csr *dir[2];
+	FILE           *fp;
+	int             d;
+
+	dir[0] = g;
+	dir[1] = rg;
+	wg_uf_init(&uf, g->n);
+	gone = (uint32_t *) wg_calloc(g->n, sizeof(uint32_t));
+	mark = (uint32_t *) wg_calloc(g->n, sizeof(uint32_t));
+	first = (uint32_t *) wg_malloc(g->n * sizeof(uint32_t));
+	last = (uint32_t *) wg_malloc(g->n * sizeof(uint32_t));
+	next = (uint32_t *) wg_malloc(g->n * sizeof(uint32_t));
+	parts = (uint32_t *) wg_malloc(g->n * sizeof(uint32_t));
+	giant = (uint32_t *) wg_malloc(k * sizeof(uint32_t));
+	/* islands: members, size and start in mem, first island of each cut */
+	mem = (uint32_t *) wg_malloc(mcap * sizeof(uint32_t));
+	isize = (uint32_t *) wg_malloc(icap * sizeof(uint32_t));
+	istart = (size_t *) wg_malloc(icap * sizeof(size_t));
+	ifirst = (uint32_t *) wg_malloc(k * sizeof(uint32_t));
+
+	/* the members of the set of r are first[r], next[first[r]], ... last[r] */
+	for (v = 0; v < g->n; v++) {
+		first[v] = last[v] = v;
+		next[v] = NOT_NUMBERED;
+	}
+	for (i = 0; i < k; i++) {
+		gone[order[i]] = i + 1;
+	}
 
-		RB_INSERT(node_tree, result, e->vert);
-		c++;
-		if (dumpflag) {
-			fprintf(maxcomp, "p%s\n", e->vert->id);
-			LIST_FOREACH(el, e->vert->predecessors, sl_elem) {
-				fprintf(maxcomp, "s%s\n", el->vert->id);
+	/* the graph with all k keys cut */
+	for (v = 0; v < g->n; v++) {
+		if (gone[v]) {
+			continue;
+		}
+		for (e = g->off[v]; e < g->off[v + 1]; e++) {
+			w = g->adj[e];
+			if (!gone[w] && (x = wg_uf_find(&uf, v)) != (r = wg_uf_find(&uf, w))) {
+				/* x and r swap places if w's set is bigger */
+				merged = wg_uf_union(&uf, x, r);
+				if (merged == r) {
+					r = x;
+				}
+				next[last[merged]] = first[r];
+				last[merged] = last[r];
 			}
 		}
 	}
-	if (dumpflag) {
-		fclose(maxcomp);
+	for (v = 0; v < g->n; v++) {
+		if (!gone[v] && uf.size[wg_uf_find(&uf, v)] > maxsize) {
+			maxsize = uf.size[wg_uf_find(&uf, v)];
+		}
 	}
-	fprintf(stderr, "Inserted %d nodes\n", c);
-	return max;
-}
 
-/* Remove a vertex from the graph */
-void 
-cutat(struct node_tree * t, vertex cut)
-{
-	vertex          v;
-	struct _listelem *e;
-	RB_FOREACH(v, node_tree, t) {
-		LIST_FOREACH(e, v->successors, sl_elem) {
-			if (e->vert == cut) {
-				LIST_REMOVE(e, sl_elem);
+	/* put the keys back, last cut first */
+	for (step = k; step-- > 0;) {
+		x = order[step];
+		giant[step] = maxsize;
+
+		/* the parts x connects */
+		np = 0;
+		for (d = 0; d < 2; d++) {
+			for (e = dir[d]->off[x]; e < dir[d]->off[x + 1]; e++) {
+				w = dir[d]->adj[e];
+				if (gone[w]) {
+					continue;
+				}
+				r = wg_uf_find(&uf, w);
+				if (mark[r] != step + 1) {
+					mark[r] = step + 1;
+					parts[np++] = r;
+				}
 			}
 		}
-		LIST_FOREACH(e, v->predecessors, sl_elem) {
-			if (e->vert == cut) {
-				LIST_REMOVE(e, sl_elem);
+		merged = 1;
+		big = 0;
+		for (i = 0; i < np; i++) {
+			merged += uf.size[parts[i]];
+			if (uf.size[parts[i]] > uf.size[parts[big]]) {
+				big = i;
 			}
 		}
+
+		/* all but the biggest part are islands if x was in the giant */
+		ifirst[step] = nisl;
+		for (i = 0; np > 1 && merged >= maxsize && i < np; i++) {
+			if (i == big) {
+				continue;
+			}
+			if (nisl == icap) {
+				icap *= 2;
+				isize = (uint32_t *) wg_realloc(isize, icap * sizeof(uint32_t));
+				istart = (size_t *) wg_realloc(istart, icap * sizeof(size_t));
+			}
+			istart[nisl] = nmem;
+			isize[nisl++] = uf.size[parts[i]];
+			for (v = first[parts[i]]; v != NOT_NUMBERED; v = next[v]) {
+				if (nmem == mcap) {
+					mcap *= 2;
+					mem = (uint32_t *) wg_realloc(mem, mcap * sizeof(uint32_t));
+				}
+				mem[nmem++] = v;
+			}
+		}
+
+		/* x is back */
+		gone[x] = 0;
+		for (i = 0; i < np; i++) {
+			x = wg_uf_find(&uf, order[step]);
+			r = parts[i];
+			merged = wg_uf_union(&uf, x, r);
+			if (merged == r) {
+				r = x;
+			}
+			next[last[merged]] = first[r];
+			last[merged] = last[r];
+		}
+		r = wg_uf_find(&uf, order[step]);
+		if (uf.size[r] > maxsize) {
+			maxsize = uf.size[r];
+		}
+	}
+
+	/* islands were found last cut first */
+	if ((fp = fopen(ISLANDFILE, "w")) == NULL) {
+		fprintf(stderr, "Could not write to %s\n", ISLANDFILE);
+		exit(1);
+	}
+	for (step = 0; step < k; step++) {
+		fprintf(fp, "c%u;" KEYFMT ";%u\n", step + 1, idlen,
+			index[order[step]], giant[step]);
+		for (i = ifirst[step]; i < ((step > 0) ? ifirst[step - 1] : nisl); i++) {
+			fprintf(fp, "i%u;", isize[i]);
+			for (e = 0; e < isize[i]; e++) {
+				fprintf(fp, "%s" KEYFMT, e ? " " : "", idlen,
+					index[mem[istart[i] + e]]);
+			}
+			fprintf(fp, "\n");
+		}
+	}
+	fclose(fp);
+
+	wg_uf_free(&uf);
+	free(gone);
+	free(mark);
+	free(first);
+	free(last);
+	free(next);
+	free(parts);
+	free(giant);
+	free(mem);
+	free(isize);
+	free(istart);
+	free(ifirst);
+}
+
+/* Write the component to COMPFILE, with the signatures among its keys */
+void
+dump_compound(const keyid_t * index, const struct wg_csr * rg)
+{
+	FILE           *maxcomp;
+	uint32_t        v;
+	size_t          e;
+
+	if ((maxcomp = fopen(COMPFILE, "w+")) == NULL) {
+		fprintf(stderr, "Could not write to %s\n", COMPFILE);
+		exit(1);
 	}
-	RB_REMOVE(node_tree, t, cut);
+	for (v = 0; v < rg->n; v++) {
+		fprintf(maxcomp, "p" KEYFMT "\n", idlen, index[v]);
+		for (e = rg->off[v]; e < rg->off[v + 1]; e++) {
+			fprintf(maxcomp, "s" KEYFMT "\n", idlen, index[rg->adj[e]]);
+		}
+	}
+	fclose(maxcomp);
 }
 
 int
 main(int argc, char **argv)
 {
 	char           *fname = NULL;
-	char            line[20];
-	char            cur[17], id[17];
 	int             ch = 0;
 	int             total = 0;
 	int             numkeys = 0;
 	int             unknown = 0;
-	int             done = 0;
-	double          perc, todo;
-	int             span, hours, mins, secs;
-	struct timeval  tvstart, tvnow, tvdiff;
-
-	vertex          nn, searchnode, s;
-	vertex          current = NULL;
-	struct _sortelem *ord;
+	int             i;
+	struct timeval  tvstart, tvnow, tvdiff, tvphase;
+
+	uint32_t       *vmap, *members;
+	keyid_t        *index;
+	struct wg_csr   succ, pred;
+	double         *centrality, *bridge, *edge, scale;
+	struct brandes_sums sums;
+	uint32_t        src, *sources, nsources, *cut = NULL;
+	size_t          j;
 	FILE           *in;
-	struct node_tree allkeys;
-
-	RB_INIT(&allkeys);
+	struct wg_graph graph;
 
-	while ((ch = getopt(argc, argv, "l:dm")) != -1) {
+	while ((ch = getopt(argc, argv, "a:c:k:K:n:p:S:t:H:j:l:2bdDemrs")) != -1) {
 		switch (ch) {
+		case 'b':
+			batched = 1;
+			break;
+		case 'c':
+			compfile = optarg;
+			break;
 		case 'd':
 			debug = 1;
 			break;
+		case 'D':
+			degreeflag = 1;
+			break;
+		case '2':
+			twohopflag = 1;
+			break;
+		case 'e':
+			edgeflag = 1;
+			break;
+		case 'n':
+			ntop = (uint32_t) strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			reverseflag = 1;
+			break;
+		case 't':
+			topk = (uint32_t) strtoul(optarg, NULL, 10);
+			break;
+		case 'H':
+			hubwork = (size_t) strtoul(optarg, NULL, 10);
+			break;
+		case 'k':
+			ncut = (uint32_t) strtoul(optarg, NULL, 10);
+			break;
+		case 'K':
+			cutfile = optarg;
+			break;
 		case 'm':
 			dumpflag = 1;
 			break;
+		case 's':
+			strongflag = 1;
+			break;
+		case 'a':
+			epsilon = strtod(optarg, NULL);
+			if (epsilon <= 0.0 || epsilon >= 1.0) {
+				fprintf(stderr, "eps must be between 0 and 1\n");
+				exit(1);
+			}
+			break;
+		case 'p':
+			delta = strtod(optarg, NULL);
+			if (delta <= 0.0 || delta >= 1.0) {
+				fprintf(stderr, "delta must be between 0 and 1\n");
+				exit(1);
+			}
+			break;
+		case 'S':
+			srandom((unsigned int) strtoul(optarg, NULL, 10));
+			break;
+		case 'j':
+			nthreads = (int) strtoul(optarg, NULL, 10);
+			if (nthreads < 1) {
+				fprintf(stderr, "need at least one thread\n");
+				exit(1);
+			}
+			break;
 		case 'l':
 			idlen = (int) strtoul(optarg, NULL, 10);
+			if (idlen < 1 || idlen > KEYID_MAXLEN) {
+				fprintf(stderr, "ids are 1 to %d chars long\n", KEYID_MAXLEN);
+				exit(1);
+			}
 			break;
 		default:
 			usage();
@@ -691,99 +1816,69 @@ main(int argc, char **argv)
 	}
 	argc -= optind;
 	argv += optind;
+	if ((edgeflag || topk > 0) && (degreeflag || twohopflag)) {
+		fprintf(stderr, "-e and -t need betweenness, not -D or -2\n");
+		exit(1);
+	}
 
-	if (argc < 1) {
-		fprintf(stderr, "Please give file to parse\n");
+	/* no file or "-": read stdin, e.g. from keyanalyze -s */
+	if (argc < 1 || strcmp(argv[0], "-") == 0) {
+		fname = strdup("stdin");
+	} else {
+		fname = strdup(argv[0]);
 	}
-	fname = strdup(argv[0]);
 	fprintf(stderr, "fname: %s\n", fname);
 
-	if ((in = fopen(fname, "r")) == NULL) {
+	wg_lap(&tvphase);
+
+	if (argc < 1 || strcmp(argv[0], "-") == 0) {
+		in = stdin;
+	} else if ((in = fopen(fname, "r")) == NULL) {
 		fprintf(stderr, "Error opening %s: %s\n", fname, strerror(errno));
 		exit(1);
 	}
 
 	/*
-	 * We expect a file with sequences of lines:
-	 * 
-	 * p<keyid> 
-	 * s<keyid> 
-	 * ... 
-	 * p<keyid> 
-	 * s<keyid> 
-	 * ... 
-	 * where lines starting with  'p' introduce a public key
-	 * and lines starting with 's' the signatures on the key
-	 * 
-	 * Upon request from Peter Palfrader: Two runs over the file, first find
-	 * all p<key> lines, then the s<key> lines, ignoring those that have
-	 * no matching p<key> line.
+	 * See wg_load() for the file format. Self-signatures are
+	 * dropped, and so are signatures by keys that have no p<key>
+	 * line (upon request from Peter Palfrader).
 	 */
-
-	/* dummy struct _vertex. We substitute the id later and call RB_FIND */
-	searchnode = newnode("0000000000000000");
-
-	/* first run */
-	while (fgets(line, idlen + 2, in)) {
-		if (line[0] == 'p') {
-			strncpy(cur, line + 1, idlen);
-			cur[idlen] = 0;
-			searchnode->id = cur;
-			if ((current = RB_FIND(node_tree, &allkeys, searchnode)) == NULL) {
-				current = newnode(cur);
-				RB_INSERT(node_tree, &allkeys, current);
-				numkeys++;
-			}
-		}
+	if (wg_load(&graph, in, idlen, WG_SKIP_SELFSIGS) != 0) {
+		fprintf(stderr, "Error reading %s: %s\n", fname, strerror(errno));
+		exit(1);
+	}
+	if (graph.malformed) {
+		fprintf(stderr, "Malformed graphfile\n");
+		exit(1);
 	}
+	numkeys = graph.keys.n;
+	unknown = graph.unknown;
 	fprintf(stderr, "Read %d keys\n", numkeys);
-	rewind(in);
-
-	/* second run */
-	while (fgets(line, idlen + 2, in)) {
-		if (line[0] == 'p') {
-			strncpy(cur, line + 1, idlen);
-			cur[idlen] = 0;
-			searchnode->id = cur;
-			if ((current = RB_FIND(node_tree, &allkeys, searchnode)) == NULL) {
-				fprintf(stderr, "Wait a moment!\nWe should have added this (%s) before!\n", cur);
-				current = newnode(cur);
-				RB_INSERT(node_tree, &allkeys, current);
-
-			}
-		} else {
-			if (line[0] == 's') {
-				strncpy(id, line + 1, idlen);
-				/* terminate id with \0 */
-				id[idlen] = 0;
-				/* Ignore self-sigs */
-				if (strcmp(cur, id) == 0)
-					continue;
 
-				searchnode->id = id;
-				if ((nn = RB_FIND(node_tree, &allkeys, searchnode)) == NULL) {
-					unknown++;
-					/* skip id's without vertices */
-					continue;
-				}
-				if (current == NULL) {
-					fprintf(stderr, "Malformed graphfile\n");
-					exit(1);
-				}
-				add_neigh(nn, current);
-			}
-		}
-	}
+	/* signatures may be listed twice */
+	wg_edges_dedup(&graph.sigs);
 
 	fprintf(stderr, "%d signatures from keys not in the keydumps\n", unknown);
 	fprintf(stderr, "Finished parsing %s, starting the algorithm\n", fname);
+	fprintf(stderr, "Parsing took %.3f seconds\n", wg_lap(&tvphase));
 
 	if (gettimeofday(&tvstart, NULL) != 0) {
 		fprintf(stderr, "Could not get time: %s\n", strerror(errno));
 		exit(1);
 	}
 
-	total = find_biggest_compound(&allkeys, &nodeshead);
+	members = (uint32_t *) wg_malloc(numkeys * sizeof(uint32_t));
+	if (strongflag) {
+		/* e.g. keyanalyze's preprocessed.strongset */
+		for (i = 0; i < numkeys; i++) {
+			members[i] = i;
+		}
+		total = numkeys;
+	} else if (compfile != NULL) {
+		total = read_components(compfile, &graph, members);
+	} else {
+		total = find_biggest_compound(&graph, members);
+	}
 
 	if (gettimeofday(&tvnow, NULL) != 0) {
 		fprintf(stderr, "Could not get time: %s\n", strerror(errno));
@@ -792,65 +1887,95 @@ main(int argc, char **argv)
 
 	timersub(&tvnow, &tvstart, &tvdiff);
 
-	fprintf(stderr, "Found %d vertex component in %ld seconds", total,
+	fprintf(stderr, "Found %d vertex component in %ld seconds\n", total,
 		tvdiff.tv_sec);
+	fprintf(stderr, "Component search took %.3f seconds\n", wg_lap(&tvphase));
 
-	if (gettimeofday(&tvstart, NULL) != 0) {
-		fprintf(stderr, "Could not get time: %s\n", strerror(errno));
-		exit(1);
+	vmap = (uint32_t *) wg_malloc(numkeys * sizeof(uint32_t));
+	index = component_csr(members, total, &graph, vmap, &succ, &pred);
+	free(members);
+	if (ncut > succ.n) {
+		ncut = succ.n;
 	}
-
-	RB_FOREACH(s, node_tree, &nodeshead) {
-		vertex_round(s, &nodeshead);
-		done++;
-		if ((done % 100) == 1 && done > 1) {
-			if (gettimeofday(&tvnow, NULL) != 0) {
-				fprintf(stderr, "Could not get time: %s\n", strerror(errno));
-				exit(1);
+	if (cutfile != NULL) {
+		cut = (uint32_t *) wg_malloc(succ.n * sizeof(uint32_t));
+		ncut = read_cut_order(cutfile, vmap, &graph, cut, ncut);
+	}
+	sums_alloc(&sums, &pred, edgeflag, topk > 0);
+	free(vmap);
+	wg_graph_free(&graph);
+	if (dumpflag) {
+		dump_compound(index, &pred);
+	}
+	centrality = sums.centrality;
+	bridge = sums.bridge;
+	edge = sums.edge;
+	if (degreeflag) {
+		/* signatures made plus signatures received */
+		for (src = 0; src < succ.n; src++) {
+			centrality[src] = (double) (succ.off[src + 1] - succ.off[src] +
+					      pred.off[src + 1] - pred.off[src]);
+		}
+	} else if (twohopflag) {
+		twohop(&succ, nthreads, centrality);
+	} else {
+		if (topk > 0 && topk < succ.n) {
+			nsources = topk_sample(&succ, &pred, index, topk, &sums);
+			fprintf(stderr, "Sampled %u of %u sources\n", nsources, succ.n);
+		} else {
+			/* with -t n or more every key is in the top: exact */
+			nsources = (epsilon > 0.0 && topk == 0) ?
+				sample_size(succ.n, epsilon, delta) : succ.n;
+			sources = sample_sources(succ.n, nsources);
+			if (nsources < succ.n) {
+				fprintf(stderr, "Sampling %u of %u sources\n", nsources, succ.n);
 			}
-			/* Convoluted machinations to get the ETA */
-			span = tvnow.tv_sec - tvstart.tv_sec;
-			perc = (double) done;
-			perc /= total;
-			todo = (((double) span) / perc) - (double) span;
-			perc *= 100;
-
-			hours = (int) floor(todo / 3600);
-			todo -= (hours * 3600.0);
-			mins = (int) floor(todo / 60);
-			todo -= (mins * 60.0);
-			secs = (int) floor(todo);
+			betweenness(&succ, &pred, index, sources, nsources, nthreads, &sums);
+			free(sources);
+		}
 
-			fprintf(stderr, "%d\tof %d done\t( %.3f %%)\t(ETA %dh%02dm%02ds)\n", done, total, perc, hours, mins, secs);
+		/* scale sampled dependencies up to the whole graph */
+		if (nsources < succ.n) {
+			scale = (double) succ.n / nsources;
+			for (src = 0; src < succ.n; src++) {
+				centrality[src] *= scale;
+				bridge[src] *= scale;
+			}
+			for (j = 0; edge != NULL && j < pred.m; j++) {
+				edge[j] *= scale;
+			}
 		}
 	}
-
 	fprintf(stderr, "Finished computation, sorting by centrality\n");
-
-	RB_FOREACH(s, node_tree, &nodeshead) {
-		struct _sortelem *so, *found;
-		struct _listelem *e;
-		so = sort_alloc();
-		e = list_alloc();
-		so->centrality = s->centrality;
-		e->vert = s;
-		/* Already got a vertex with same centrality? */
-		if ((found = RB_INSERT(sort_tree, &sorthead, so)) != NULL) {
-			LIST_INSERT_HEAD(found->vertices, e, sl_elem);
-		} else {
-			/* First vertex with this centrality */
-			LIST_INIT(so->vertices);
-			LIST_INSERT_HEAD(so->vertices, e, sl_elem);
-		}
+	fprintf(stderr, "%s took %.3f seconds\n",
+		degreeflag ? "Degree" : twohopflag ? "Two-hop" : "Betweenness",
+		wg_lap(&tvphase));
+
+	if (edge != NULL) {
+		write_edges(&pred, index, edge);
+		fprintf(stderr, "Edge betweenness written to %s\n", EDGEFILE);
+		fprintf(stderr, "Edge sorting took %.3f seconds\n", wg_lap(&tvphase));
 	}
 
-	/* print list sorted by centrality  */
-	RB_FOREACH(ord, sort_tree, &sorthead) {
-		struct _listelem *e;
-		LIST_FOREACH(e, ord->vertices, sl_elem) {
-			printf("%s;%.9f\n", e->vert->id, ord->centrality);
+	if (ncut > 0) {
+		if (cut == NULL) {
+			cut = cut_order(centrality, succ.n, ncut);
 		}
+		cut_islands(&succ, &pred, index, cut, ncut);
+		fprintf(stderr, "Cut %u keys, islands written to %s\n", ncut, ISLANDFILE);
+		fprintf(stderr, "Island search took %.3f seconds\n", wg_lap(&tvphase));
+		free(cut);
+	}
+	if (topk > 0 && (ntop == 0 || ntop > topk)) {
+		/* only the top k are worth printing */
+		ntop = topk;
 	}
+	print_ranking(index, centrality, bridge, succ.n, ntop);
+	sums_free(&sums);
+	free(index);
+	wg_csr_free(&succ);
+	wg_csr_free(&pred);
+	fprintf(stderr, "Sorting took %.3f seconds\n", wg_lap(&tvphase));
 
 	fclose(in);
 
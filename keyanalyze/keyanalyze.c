@@ -16,9 +16,9 @@ static char *infile     = "preprocess.keys";
 static char *outdir     = "output/";
 static short noindiv    = 0;
 static short new_output = 0;
+static short strongset_stdout = 0;
 static short outsubdirs = 1; /* create output/12/12345678 or output/12345678 */
 
-#define MAXKEYS 	400000 /* MUST be > `grep p preprocess.keys | wc` */
 #define MINSETSIZE	10 /* minimum set size we care about for strong sets */
 #define MAXHOPS		30 /* max hop count we care about for report */
 
@@ -28,215 +28,93 @@ static short outsubdirs = 1; /* create output/12/12345678 or output/12345678 */
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <pthread.h>
 
-/* globals */
-struct sig {
-	int id;
-	struct sig *next;
-};
-typedef struct sig sig;
+#include "wotgraph.h"
 
+/* globals */
 struct threadparam {
 	unsigned int threadnum;
 };
 typedef struct threadparam threadparam;
 
-struct keydata {
-	unsigned int id1;
-	unsigned int id2;
-	sig *to;
-	sig *from;
-	unsigned int in_degree;
-	unsigned int out_degree;
-};
+/* the two halves of a key id, as printed in the reports */
+#define ID1(i) ((unsigned int) (graph.keys.ids[(i)] >> 32))
+#define ID2(i) ((unsigned int) (graph.keys.ids[(i)] & 0xffffffff))
 
-struct keydata	keys[MAXKEYS];
+struct wg_graph	graph;
+struct wg_csr	to;		/* to[i]: keys that signed key i */
+struct wg_csr	from;	/* from[i]: keys signed by key i */
 FILE 			*fpin, *fpout, *fpstat, *fpsets, *fpsetsize, *fpmsd, *fppreproc;
 unsigned int 	numkeys = 0;
 unsigned int	numsigs = 0;
-int			    component[MAXKEYS];
+int			    *component;
 int			    max_component;
 int			    max_size;
-int			    reachable[MAXKEYS];
+unsigned char   *reachable;
 int			    num_reachable;
 float 			meantotal;
 pthread_mutex_t mean_l;
 pthread_mutex_t print_preprocessed;
 
 /* declarations */
-void AddKey (unsigned char *newid);
-void AddSig (int src, int dst);
 void CloseFiles();
-int CountSigs(sig *current);
-unsigned int ConvertFromHex (const unsigned char *c);
-int GetKeyById(const unsigned char* searchid);
-void MeanCrawler(unsigned int *distset, int id, unsigned int len);
-float MeanDistance(int id, unsigned int *hops, unsigned int *hophigh, sig **farthest);
+float MeanDistance(int id, unsigned int *hops, unsigned int *hophigh,
+	uint32_t *farthest, unsigned int *nfarthest, uint32_t *dist, uint32_t *queue);
+double Seconds(void);
 
 /* ################################################################# */
 /* helper functions, in alpha order */
 
-void AddKey (unsigned char *newid) {
-	struct keydata *key = &keys[numkeys++];
-
-	/* assume no dupes for now */
-	key->id1 = ConvertFromHex(newid);
-	key->id2 = ConvertFromHex(newid+8);
-}
-
-void AddKeyToList(sig **pptr, int id)
-{
-	while (*pptr)
-		pptr = &(*pptr)->next;
-
-	*pptr = (sig *) calloc (1,sizeof(sig));
-	(*pptr)->id = id;
-}
-
-void AddSig (int src, int dst) {
-	/* if GetKeyById returned -1, then we exit here */
-	if ((src == -1) || (dst == -1))
-		return;
-
-	AddKeyToList(&keys[dst].to, src);
-	AddKeyToList(&keys[src].from, dst);
-	
-	keys[dst].in_degree++;
-	keys[src].out_degree++;
-	
-	numsigs++;
-}
-
 void CloseFiles() {
 	fclose(fpin);
 	fclose(fpout);
 }
 
-int CountSigs(sig *current) {
-	int ret = 0;
-
-	while (current->next) {
-		current = current->next;
-		ret++;
-	}
-
-	return ret;
-}
-
-unsigned int ConvertFromHex (const unsigned char *c) {
-	char buf1[5];
-	char buf2[5];
-	unsigned int ret;
-
-	buf1[4] = 0;
-	buf2[4] = 0;
-	memcpy (buf1,c,4);
-	memcpy (buf2,c+4,4);
-	ret = strtoul(buf1,NULL,16)*65536 + strtoul(buf2,NULL,16);
-	return ret;
-}
-
-void DeleteKeyList(sig **pptr)
-{
-	sig *current = *pptr;
-
-	while (*pptr) {
-		current = (*pptr)->next;
-		free (*pptr);
-		*pptr = current;
-	}
-}
-
-/* recursive function to mark connected keys in the connected set */
-int DFSMarkConnected (int *markset, int id) {
-	sig *psig;
-	int num = 1;
-	/* mark this node, call this function for all subnodes that aren't
-	 * marked already */
-	markset[id] = 1;
-	for (psig = keys[id].from; psig; psig = psig->next) {
-		if (!markset[psig->id])
-			num += DFSMarkConnected (markset, psig->id);
-	}
-
-	return num;
-}
-
-int GetKeyById(const unsigned char* searchid) {
-	unsigned int i;
-	unsigned int s1,s2;
-
-	s1 = ConvertFromHex(searchid);
-	s2 = ConvertFromHex(searchid+8);
-	for (i = 0; i < numkeys; i++) {
-		struct keydata *key = &keys[i];
-		if ((s1 == key->id1) && (s2 == key->id2)) {
-			return i;
-		}
-	}
-	return (-1);
-}
-
-/* new _much_ faster BFS version of MeanCrawler() contributed by
- * Hal J. Burch <hburch@halport.lumeta.com> */
-void MeanCrawler(unsigned int *distset, int id, unsigned int len) {
-	sig *psig;
-	int queue[MAXKEYS];
-	int qhead, qtail;
-
-	memset(queue,0,sizeof(int)*MAXKEYS);
-	queue[0] = id;
-	distset[id] = 0;
-	qhead = 0;
-	qtail = 1;
-
-	while (qtail > qhead) {
-		id = queue[qhead++];
-		len = distset[id];
-		psig = keys[id].to;
-		while (psig) {
-			if ((len+1) < distset[psig->id]) {
-				distset[psig->id] = len+1;
-				queue[qtail++] = psig->id;
-			}
-			psig = psig->next;
-		}
-	}
-} 
-
-float MeanDistance(int id, unsigned int *hops, unsigned int *hophigh, sig **farthest) {
-	unsigned int dist[MAXKEYS];
-	unsigned int i;
+/* BFS over the signatures to key id. dist[] must be all WG_UNREACHED
+ * and is left that way; queue is scratch space for the BFS. The keys
+ * farthest away are stored in farthest[]. */
+float MeanDistance(int id, unsigned int *hops, unsigned int *hophigh,
+	uint32_t *farthest, unsigned int *nfarthest, uint32_t *dist, uint32_t *queue) {
+	unsigned int i, reached;
 	unsigned int totaldist = 0;
 
-	/* init to a large value here, so shortest distance will always be
-	 * less */
-	memset(dist,100,sizeof(int)*MAXKEYS);
-
-	MeanCrawler (dist, id, 0);
+	reached = wg_bfs(&to, id, dist, queue);
 
+	*nfarthest = 0;
 	for (i=0;i<numkeys;i++) {
 		if (component[i] == max_component) {
 			totaldist += dist[i];
 			if (dist[i] < MAXHOPS) hops[dist[i]]++;
 			if (dist[i] > *hophigh) {
 				*hophigh = dist[i];
-				DeleteKeyList(farthest);
+				*nfarthest = 0;
 			}
 			if (dist[i] == *hophigh) {
-				AddKeyToList(farthest, i);
+				farthest[(*nfarthest)++] = i;
 			}
 		}
 	}
 
+	for (i=0;i<reached;i++)
+		dist[queue[i]] = WG_UNREACHED;
+
 	if (*hophigh > MAXHOPS) *hophigh = MAXHOPS;
 
 	return ((float)totaldist / (max_size - 1));
 }
 
+/* wall clock time, for the phase timings in status.txt */
+double Seconds(void) {
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
 FILE *OpenFileById(unsigned int id) {
 	char buf[255];
 	char idchr[9];
@@ -298,11 +176,15 @@ int OpenFiles() {
 		fpsetsize = fopen(buf,"w");
 		if (!fpsetsize) return 1;
 	
-		buf[0] = '\0';
-		strcat(buf, outdir);
-		strcat(buf,"preprocessed.strongset");
-		fppreproc = fopen(buf,"w");
-		if (!fppreproc) return 1;
+		if (strongset_stdout) {
+			fppreproc = stdout;
+		} else {
+			buf[0] = '\0';
+			strcat(buf, outdir);
+			strcat(buf,"preprocessed.strongset");
+			fppreproc = fopen(buf,"w");
+			if (!fppreproc) return 1;
+		}
 	}
 	
 	/* other output file */
@@ -320,17 +202,19 @@ void ParseArgs(int argc, char **argv)
 	int outdirlen;
 
 	while (1) {
-		int option = getopt(argc, argv, "hi:o:1Nn");
+		int option = getopt(argc, argv, "hi:o:1Nns");
 		if (option == -1)
 			break;
 		switch (option) {
 		case 'h':
-			printf ("Usage: %s [-h1Nn] [-i infile] [-o outdir]\n", argv[0]);
+			printf ("Usage: %s [-h1Nns] [-i infile] [-o outdir]\n", argv[0]);
 			printf ("\t-h\tPrint this help screen\n");
 			printf ("\t-1\tDo not create subdirectories for individual reports\n");
 			printf ("\t\t(outdir/12345678 instead of outdir/12/12345678)\n");
 			printf ("\t-N\tDo not create individual reports\n");
 			printf ("\t-n\tUse new output format\n");
+			printf ("\t-s\tWrite the strong set to stdout instead of\n");
+			printf ("\t\tpreprocessed.strongset (implies -n)\n");
 			exit (0);
 			break;
 		case 'i':
@@ -342,6 +226,10 @@ void ParseArgs(int argc, char **argv)
 		case 'n':
 			new_output = 1;
 			break;
+		case 's':
+			new_output = 1;
+			strongset_stdout = 1;
+			break;
 		case 'o':
 			outdir = optarg;
 			outdirlen = strlen(outdir);
@@ -364,54 +252,31 @@ void ParseArgs(int argc, char **argv)
 	}
 }
 
-int PrintKeyList(FILE *f, sig *s)
+int PrintKeyList(FILE *f, const uint32_t *list, size_t n)
 {
-	int i = 0;
-	struct keydata *key;
+	size_t i;
 	
-	while (s) {
-		key = &keys[s->id];
-		fprintf(f, "  %08X %08X\n", key->id1, key->id2);
-		s = s->next;
-		i++;
-	}
+	for (i = 0; i < n; i++)
+		fprintf(f, "  %08X %08X\n", ID1(list[i]), ID2(list[i]));
 	return i;
 }
 
+/* Single pass over the input; signatures may refer to keys that are
+ * introduced later in the file. */
 void ReadInput() {
-	unsigned char buf[20];
-	int currentkey = -1;
-	
-	fprintf(fpstat,"Importing pass 1 (keys)...\n");
-	while (fread(buf,1,18,fpin) == 18) {
-		if (buf[17] != '\n') continue;
-		if (buf[0] == 'p') {
-			AddKey(buf+1);
-		}
+	fprintf(fpstat,"Importing keys and sigs...\n");
+	if (wg_load(&graph, fpin, 16, 0) != 0) {
+		fprintf(fpstat,"Error reading input.\n");
+		exit(EXIT_FAILURE);
 	}
-	fprintf(fpstat,"done.\n");
-	fprintf(fpstat,"%d keys imported\n",numkeys);
+	numkeys = graph.keys.n;
+	numsigs = graph.sigs.n;
+
+	wg_csr_build(&to, numkeys, &graph.sigs, WG_REVERSE);
+	wg_csr_build(&from, numkeys, &graph.sigs, WG_FORWARD);
 
-	rewind(fpin);
-	fprintf(fpstat,"Importing pass 2 (sigs)...\n");
-	while (fread(buf,1,18,fpin) == 18) {
-		if (buf[17] != '\n') continue;
-		if (buf[0] == 'p') {
-			currentkey = GetKeyById(buf+1);
-			if (currentkey == -1) {
-				fprintf(fpstat,"Error finding key in pass 2.\n");
-				exit(EXIT_FAILURE);
-			}
-		}
-		if (buf[0] == 's') {
-				AddSig(GetKeyById(buf+1),currentkey);
-				if ((numsigs%1000) == 0) {
-					fprintf(fpstat,"%d sigs imported...\n",numsigs);
-					fflush(fpstat);
-				}
-		} 
-	}
 	fprintf(fpstat,"done.\n");
+	fprintf(fpstat,"%d keys imported\n",numkeys);
 	fprintf(fpstat,"%d sigs imported\n",numsigs);
 }
 
@@ -424,65 +289,43 @@ void SaveState() {
 	 * linked lists of sigs first */
 }
 
-int dfsnum[MAXKEYS];
-int lownum[MAXKEYS];
-int removed[MAXKEYS];
-int stack[MAXKEYS];
-int stackindex;
-int lastdfsnum;
-
-void DFSVisit(int id) {
-	sig *psig;
-
-	dfsnum[id] = lownum[id] = ++lastdfsnum;
-	stack[stackindex++] = id;
-
-	for (psig = keys[id].to; psig; psig = psig->next) {
-		int neighbor = psig->id;
-
-		if (removed[neighbor])
-			continue;
+void TestConnectivity() {
+	struct wg_scc scc;
+	uint32_t c, *dist;
+	size_t j;
+	unsigned int i;
 
-		if (!dfsnum[neighbor]) {
-			DFSVisit (neighbor);
+	/* Tarjan over the signatures to each key */
+	wg_scc(&to, &scc);
 
-			if (lownum[neighbor] < lownum[id])
-				lownum[id] = lownum[neighbor];
-		} else if (dfsnum[neighbor] < lownum[id])
-			lownum[id] = dfsnum[neighbor];
-	}
+	component = malloc(numkeys * sizeof(int));
+	for (c = 0; c < scc.ncomp; c++) {
+		int id = scc.root[c];
+		int size = scc.off[c + 1] - scc.off[c];
 
-	if (lownum[id] == dfsnum[id]) {
-		int i, size = 0;
-
-		do {
-			struct keydata *key;
-			i = stack[--stackindex];
-			key = &keys[i];
+		for (j = scc.off[c]; j < scc.off[c + 1]; j++) {
+			i = scc.members[j];
 			component[i] = id;
-			removed[i] = 1;
-			size++;
-			fprintf(fpsets, "%08X%08X;%d\n", key->id1, key->id2, id);
-		} while (i != id);
-
-		fprintf(fpsetsize,
-			"%d;%d\n", id, size);
-
-		if (max_size < size) {
-			max_size = size;
-			max_component = id;
+			fprintf(fpsets, "%08X%08X;%d\n", ID1(i), ID2(i), id);
 		}
-	}
-}
 
-void TestConnectivity() {
-	unsigned int i;
+		if (new_output)
+			fprintf(fpsetsize,
+				"%d;%d\n", id, size);
+	}
+	max_component = scc.root[scc.giant];
+	max_size = scc.off[scc.giant + 1] - scc.off[scc.giant];
+	wg_scc_free(&scc);
 
+	/* keys reachable from the strong set following signatures */
+	dist = malloc(numkeys * sizeof(uint32_t));
+	reachable = malloc(numkeys);
 	for (i = 0; i < numkeys; i++)
-		if (!dfsnum[i])
-			DFSVisit (i);
-
-	num_reachable = DFSMarkConnected (reachable, max_component);
+		dist[i] = WG_UNREACHED;
+	num_reachable = wg_bfs(&from, max_component, dist, NULL);
+	for (i = 0; i < numkeys; i++)
+		reachable[i] = dist[i] != WG_UNREACHED;
+	free(dist);
 
 	fprintf(fpstat,"reachable set is size %d\n", num_reachable);
 	fprintf(fpstat,"strongly connected set is size %d\n", max_size);
@@ -495,7 +338,7 @@ void IndivReport(FILE *fp,int key) {
 	int totalsigsto, totalsigsfrom;
 
 	/* head of report */
-	fprintf(fp,"KeyID %08X %08X\n\n", keys[key].id1, keys[key].id2);
+	fprintf(fp,"KeyID %08X %08X\n\n", ID1(key), ID2(key));
 
 	fprintf(fp,"This individual key report was generated as part of the monthly keyanalyze\n");
 	fprintf(fp,"report at http://dtype.org/keyanalyze/.\n\n");
@@ -504,11 +347,11 @@ void IndivReport(FILE *fp,int key) {
 	fprintf(fp,"includes keys with signatures other than their own.\n\n");
 
 	fprintf(fp,"Signatures to this key:\n");
-	totalsigsto = PrintKeyList(fp, keys[key].to);
+	totalsigsto = PrintKeyList(fp, to.adj + to.off[key], to.off[key + 1] - to.off[key]);
 	fprintf(fp,"Total: %d signatures to this id from this set\n\n",totalsigsto);
 		 
 	fprintf(fp,"Signatures from this key:\n");
-	totalsigsfrom = PrintKeyList(fp, keys[key].from);
+	totalsigsfrom = PrintKeyList(fp, from.adj + from.off[key], from.off[key + 1] - from.off[key]);
 	fprintf(fp,"Total: %d signatures from this id to this set\n\n",totalsigsfrom);
 }
 
@@ -519,26 +362,33 @@ void IndivReport(FILE *fp,int key) {
 void *thread_slave(void *arg) {
 	unsigned int 	i,j;
 	float 	threadmean;
-	sig	*distant_sigs = NULL;
+	uint32_t	*distant_sigs, *dist, *queue;
+	unsigned int	ndistant;
 	FILE	*fpindiv;
 
 	unsigned int hops[MAXHOPS]; /* array for hop histogram */
 	unsigned int hophigh; /* highest number of hops for this key */
 	short        in_strong_set;
 	unsigned int in_degree_strong, out_degree_strong, cross_degree, cross_degree_strong;
-	sig *s1, *s2;
+	size_t e1, e2;
+	uint32_t s1;
 
 	threadparam data = *(threadparam *)arg;
 
+	distant_sigs = malloc(numkeys * sizeof(uint32_t));
+	queue = malloc(numkeys * sizeof(uint32_t));
+	dist = malloc(numkeys * sizeof(uint32_t));
+	for (i=0; i<numkeys; i++)
+		dist[i] = WG_UNREACHED;
+
 	for (i=0; i<numkeys; i++) {
-		struct keydata *key = &keys[i];
 		/* do this for all set2 now */
 		if (reachable[i] && ((i%2)==data.threadnum)) {
 			/* zero out hop histogram */
 			memset(hops, 0, sizeof(int) * MAXHOPS);
 			hophigh = 0;
 
-			threadmean = MeanDistance (i, hops, &hophigh, &distant_sigs);
+			threadmean = MeanDistance (i, hops, &hophigh, distant_sigs, &ndistant, dist, queue);
 			
 		    in_strong_set       = IN_STRONG_SET(i);
 		    cross_degree        = 0;
@@ -550,21 +400,21 @@ void *thread_slave(void *arg) {
 			    pthread_mutex_lock (&print_preprocessed);
 			    
 			    if (in_strong_set)
-			        fprintf (fppreproc, "p%08X%08X\n", key->id1, key->id2);
+			        fprintf (fppreproc, "p%08X%08X\n", ID1(i), ID2(i));
 			        
-			    for (s1 = key->to; s1; s1 = s1->next) {
-			    	if (IN_STRONG_SET(s1->id)) {
+			    for (e1 = to.off[i]; e1 < to.off[i + 1]; e1++) {
+			    	s1 = to.adj[e1];
+			    	if (IN_STRONG_SET(s1)) {
 			    		++in_degree_strong;
 			    		if (in_strong_set) {
-			    			struct keydata *signer = &keys[s1->id];
-			    			fprintf (fppreproc, "s%08X%08X\n", signer->id1, signer->id2);
+			    			fprintf (fppreproc, "s%08X%08X\n", ID1(s1), ID2(s1));
 			    		}
 			    	}
 
-			    	for (s2 = key->from; s2; s2 = s2->next) {
-			    	    if (s1->id == s2->id) {
+			    	for (e2 = from.off[i]; e2 < from.off[i + 1]; e2++) {
+			    	    if (s1 == from.adj[e2]) {
 			    	    	++cross_degree;
-			    	    	if (IN_STRONG_SET(s1->id))
+			    	    	if (IN_STRONG_SET(s1))
 			    	    		++cross_degree_strong;
 			    	    	break;
 			    	    }
@@ -574,8 +424,8 @@ void *thread_slave(void *arg) {
 				fflush (fppreproc);
 			    pthread_mutex_unlock (&print_preprocessed);
 			    
-			    for (s1 = key->from; s1; s1 = s1->next) {
-			    	if (IN_STRONG_SET(s1->id))
+			    for (e1 = from.off[i]; e1 < from.off[i + 1]; e1++) {
+			    	if (IN_STRONG_SET(from.adj[e1]))
 			    		++out_degree_strong;
 			    }
 			}
@@ -584,19 +434,20 @@ void *thread_slave(void *arg) {
 
 			if (new_output) {
 		        fprintf(fpmsd, "%08X%08X;%8.5f;%d;%d;%d;%d;%d;%d;%d;%d\n",
-		            key->id1, key->id2, threadmean,
-		            key->in_degree, key->out_degree, cross_degree,
+		            ID1(i), ID2(i), threadmean,
+		            (unsigned int) (to.off[i + 1] - to.off[i]),
+		            (unsigned int) (from.off[i + 1] - from.off[i]), cross_degree,
 		            in_degree_strong, out_degree_strong, cross_degree_strong,
 		            hophigh, in_strong_set ? 1 : 0); 
 			} else {
-			    fprintf(fpmsd,"%08X %08X %8.4f\n" ,key->id1, key->id2, threadmean);
+			    fprintf(fpmsd,"%08X %08X %8.4f\n" ,ID1(i), ID2(i), threadmean);
 			}
 			fflush(fpmsd);
 			pthread_mutex_unlock(&mean_l);
 
 			/* individual report */
 			if (!noindiv) {
-	    		fpindiv = OpenFileById(key->id2);
+	    		fpindiv = OpenFileById(ID2(i));
 	    		IndivReport(fpindiv,i);
 	    		fprintf(fpindiv, "This key is %sin the strong set.\n", in_strong_set ? "" : "not ");
 	    		fprintf(fpindiv, "Mean distance to this key from strong set: %8.5f\n\n", threadmean);
@@ -604,17 +455,17 @@ void *thread_slave(void *arg) {
 	    		for (j=0;j<=hophigh;j++) {
 	    			fprintf(fpindiv,"%2d hops: %5d\n",j,hops[j]);
 	    	 	}
-	    		if (distant_sigs) {
+	    		if (ndistant) {
     				fprintf(fpindiv,"\nFarthest keys (%d hops):\n", j-1);
-				    PrintKeyList(fpindiv, distant_sigs);
-				    DeleteKeyList(&distant_sigs);
+				    PrintKeyList(fpindiv, distant_sigs, ndistant);
 			    }
 			    fclose(fpindiv);
-			} else {
-				DeleteKeyList (&distant_sigs);
 			}
 		} 
 	}
+	free(distant_sigs);
+	free(queue);
+	free(dist);
 	return NULL;
 }
 
@@ -626,14 +477,20 @@ int main(int argc, char **argv)
 	pthread_t 	*slave0, *slave1;
 	threadparam arg0,arg1;
 	void 	 	*retval;
+	double		t;
 
 	ParseArgs(argc, argv);
 	if (OpenFiles()) {
 		fprintf(stderr, "Error opening files.\n");
 		exit(EXIT_FAILURE);
 	}
+	t = Seconds();
 	ReadInput();
+	fprintf(fpstat,"Import took %.3f seconds\n", Seconds() - t);
+	t = Seconds();
 	TestConnectivity();
+	fprintf(fpstat,"Connectivity took %.3f seconds\n", Seconds() - t);
+	t = Seconds();
 	
 	pthread_mutex_init (&mean_l, NULL);
 	pthread_mutex_init (&print_preprocessed, NULL);
@@ -651,6 +508,7 @@ int main(int argc, char **argv)
 	}
 	pthread_join(*slave0, &retval);
 	pthread_join(*slave1, &retval);
+	fprintf(fpstat,"Mean distances took %.3f seconds\n", Seconds() - t);
 
 	fprintf(fpout,"Average mean is %9.4f\n",meantotal/num_reachable);
 	/* ReportMostSignatures(); */
@@ -117,69 +117,101 @@ short pgp_get_abilities (unsigned char type)
   return (pgp_canencrypt (type) << 1) | pgp_cansign (type);
 }
 
-void pgp_free_sig_subpkt (pgp_sig_subpk_t **sigp)
+/*
+ * The arena hands out memory by bumping a pointer through chunks of
+ * at least ARENA_CHUNK bytes, each one twice the size of the one
+ * before. A reset takes everything back at once and keeps the last,
+ * biggest, chunk, so once the first few key blocks are through,
+ * parsing one does not go to malloc () at all.
+ */
+
+#define ARENA_CHUNK (64 << 10)
+
+/* enough for any of the key block structures */
+#define ARENA_ALIGN(n) (((n) + 15) & ~(size_t) 15)
+
+#define ARENA_HDR ARENA_ALIGN (sizeof (pgp_arena_chunk_t))
+
+void pgp_arena_init (pgp_arena_t *a)
 {
-  pgp_sig_subpk_t *sp, *q;
-  
-  if (!sigp || !*sigp)
-    return;
-    
-  for (sp = *sigp; sp; sp = q)
+  memset (a, 0, sizeof (pgp_arena_t));
+}
+
+void *pgp_arena_malloc (pgp_arena_t *a, size_t n)
+{
+  pgp_arena_chunk_t *c;
+  size_t size;
+  void *p;
+
+  n = ARENA_ALIGN (n ? n : 1);
+  if (n > a->left)
   {
-    if (sp->data)
-        safe_free (&(sp->data));
-    q = sp->next;
-    safe_free (&sp);
+    size = a->chunks ? 2 * a->chunks->size : ARENA_CHUNK;
+    if (size < n)
+      size = n;
+    c = safe_malloc (ARENA_HDR + size);
+    c->size = size;
+    c->next = a->chunks;
+    a->chunks = c;
+    a->next = (unsigned char *) c + ARENA_HDR;
+    a->left = c->size;
   }
-  
-  *sigp = NULL;
+  p = a->next;
+  a->next += n;
+  a->left -= n;
+  return p;
 }
 
-void pgp_free_sig (pgp_sig_t **sigp)
+void *pgp_arena_calloc (pgp_arena_t *a, size_t n)
 {
-  pgp_sig_t *sp, *q;
-  
-  if (!sigp || !*sigp)
+  return memset (pgp_arena_malloc (a, n), 0, n);
+}
+
+char *pgp_arena_strdup (pgp_arena_t *a, const char *s)
+{
+  size_t l = strlen (s) + 1;
+
+  return memcpy (pgp_arena_malloc (a, l), s, l);
+}
+
+void pgp_arena_reset (pgp_arena_t *a)
+{
+  pgp_arena_chunk_t *c;
+
+  if (!a->chunks)
     return;
-  
-  for (sp = *sigp; sp; sp = q)
+  while ((c = a->chunks->next) != NULL)
   {
-    pgp_free_sig_subpkt (&(sp->subpackets));
-    q = sp->next;
-    safe_free (&sp);
+    a->chunks->next = c->next;
+    safe_free (&c);
   }
-  
-  *sigp = NULL;
+  a->next = (unsigned char *) a->chunks + ARENA_HDR;
+  a->left = a->chunks->size;
 }
 
-void pgp_free_uid (pgp_uid_t ** upp)
+void pgp_arena_free (pgp_arena_t *a)
 {
-  pgp_uid_t *up, *q;
+  pgp_arena_chunk_t *c;
 
-  if (!upp || !*upp)
-    return;
-  for (up = *upp; up; up = q)
+  while ((c = a->chunks) != NULL)
   {
-    q = up->next;
-    pgp_free_sig (&up->sigs);
-    safe_free (&up->addr);
-    safe_free (&up);
+    a->chunks = c->next;
+    safe_free (&c);
   }
-
-  *upp = NULL;
+  pgp_arena_init (a);
 }
 
-pgp_uid_t *pgp_copy_uids (pgp_uid_t *up, pgp_key_t *parent)
+pgp_uid_t *pgp_copy_uids (pgp_arena_t *a, pgp_uid_t *up, pgp_key_t *parent)
 {
   pgp_uid_t *l = NULL;
   pgp_uid_t **lp = &l;
 
   for (; up; up = up->next)
   {
-    *lp = safe_calloc (1, sizeof (pgp_uid_t));
+    *lp = pgp_arena_calloc (a, sizeof (pgp_uid_t));
     (*lp)->trust  = up->trust;
     (*lp)->flags  = up->flags;
-    (*lp)->addr   = safe_strdup (up->addr);
+    (*lp)->addr   = (unsigned char *) pgp_arena_strdup (a, (char *) up->addr);
     (*lp)->parent = parent;
     lp = &(*lp)->next;
   }
@@ -187,21 +219,6 @@ pgp_uid_t *pgp_copy_uids (pgp_uid_t *up, pgp_key_t *parent)
   return l;
 }
 
-static void _pgp_free_key (pgp_key_t ** kpp)
-{
-  pgp_key_t *kp;
-
-  if (!kpp || !*kpp)
-    return;
-
-  kp = *kpp;
-
-  pgp_free_uid (&kp->address);
-  safe_free (&kp->keyid);
-  safe_free (&kp->fingerprint);
-  safe_free (kpp);
-}
-
 pgp_key_t *pgp_remove_key (pgp_key_t ** klist, pgp_key_t * key)
 {
   pgp_key_t **last;
@@ -230,37 +247,3 @@ pgp_key_t *pgp_remove_key (pgp_key_t ** klist, pgp_key_t * key)
   return q;
 }
 
-void pgp_free_key (pgp_key_t ** kpp)
-{
-  pgp_key_t *p, *q, *r;
-
-  if (!kpp || !*kpp)
-    return;
-
-  if ((*kpp)->parent && (*kpp)->parent != *kpp)
-    *kpp = (*kpp)->parent;
-  
-  /* Order is important here:
-   *
-   * - First free all children.
-   * - If we are an orphan (i.e., our parent was not in the key list),
-   *   free our parent.
-   * - free ourselves.
-   */
-
-  for (p = *kpp; p; p = q)
-  {
-    for (q = p->next; q && q->parent == p; q = r)
-    {
-      r = q->next;
-      _pgp_free_key (&q);
-    }
-    if (p->parent)
-      _pgp_free_key (&p->parent);
-
-    _pgp_free_key (&p);
-  }
-
-  *kpp = NULL;
-}
-
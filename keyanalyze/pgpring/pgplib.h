@@ -104,6 +104,25 @@ typedef struct pgp_uid
 }
 pgp_uid_t;
 
+/*
+ * Everything a key block is made of is allocated from an arena,
+ * which is reset (not freed piece by piece) once it is dumped.
+ */
+typedef struct pgp_arena_chunk
+{
+  struct pgp_arena_chunk *next;
+  size_t size;			/* bytes after the header */
+}
+pgp_arena_chunk_t;
+
+typedef struct pgp_arena
+{
+  pgp_arena_chunk_t *chunks;	/* the one in use first */
+  unsigned char *next;		/* free space in it */
+  size_t left;
+}
+pgp_arena_t;
+
 enum pgp_version
 {
   PGP_V2,
@@ -125,14 +144,19 @@ typedef enum pgp_ring pgp_ring_t;
 const char *pgp_pkalgbytype (unsigned char);
 
 pgp_key_t *pgp_remove_key (pgp_key_t **, pgp_key_t *);
-pgp_uid_t *pgp_copy_uids (pgp_uid_t *, pgp_key_t *);
+pgp_uid_t *pgp_copy_uids (pgp_arena_t *, pgp_uid_t *, pgp_key_t *);
 
 short pgp_canencrypt (unsigned char);
 short pgp_cansign (unsigned char);
 short pgp_get_abilities (unsigned char);
 
-void pgp_free_key (pgp_key_t **kpp);
+void pgp_arena_init (pgp_arena_t *);
+void *pgp_arena_malloc (pgp_arena_t *, size_t);
+void *pgp_arena_calloc (pgp_arena_t *, size_t);
+char *pgp_arena_strdup (pgp_arena_t *, const char *);
+void pgp_arena_reset (pgp_arena_t *);
+void pgp_arena_free (pgp_arena_t *);
 
-#define pgp_new_keyinfo() safe_calloc (sizeof (pgp_key_t), 1)
+#define pgp_new_keyinfo(a) pgp_arena_calloc ((a), sizeof (pgp_key_t))
 
 #endif /* HAVE_PGP */
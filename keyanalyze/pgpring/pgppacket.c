@@ -22,7 +22,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "sha1.h"
 #include "lib.h"
@@ -31,195 +35,359 @@
 
 #define CHUNKSIZE 1024
 
-static unsigned char *pbuf = NULL;
-static size_t plen = 0;
+/* bytes read from a stream at a time */
+#define WINDOWSIZE (1 << 20)
 
-static int read_material (size_t material, size_t * used, FILE * fp)
+/*
+ * Open the key ring name, "-" for stdin. Regular files are mapped,
+ * anything else is streamed. Returns NULL, after telling why, if it
+ * cannot be opened.
+ */
+pgp_reader_t *pgp_open_reader (const char *name)
 {
-  if (*used + material >= plen)
+  pgp_reader_t *r;
+  struct stat st;
+  void *map = MAP_FAILED;
+  int fd;
+
+  if (!strcmp (name, "-"))
+    fd = 0;
+  else if ((fd = open (name, O_RDONLY)) == -1)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+    return NULL;
+  }
+  if (fstat (fd, &st) == -1)
+  {
+    fprintf (stderr, "%s: %s\n", name, strerror (errno));
+    if (fd > 0)
+      close (fd);
+    return NULL;
+  }
+
+  r = safe_calloc (1, sizeof (pgp_reader_t));
+  r->name = name;
+  r->fd = fd;
+
+  if (S_ISREG (st.st_mode) && st.st_size > 0)
+    map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map != MAP_FAILED)
+  {
+#ifdef MADV_SEQUENTIAL
+    madvise (map, st.st_size, MADV_SEQUENTIAL);
+#endif
+    r->data = map;
+    r->size = r->maplen = st.st_size;
+  }
+  else if (S_ISREG (st.st_mode) && st.st_size == 0)
+    r->eof = 1;
+  else
   {
-    unsigned char *p;
-    size_t nplen;
+    r->cap = WINDOWSIZE;
+    r->data = r->buf = safe_malloc (r->cap);
+    return r;
+  }
 
-    nplen = *used + material + CHUNKSIZE;
+  /* the mapping outlives the descriptor */
+  if (fd > 0)
+    close (fd);
+  r->fd = -1;
+  return r;
+}
+
+void pgp_close_reader (pgp_reader_t **rp)
+{
+  pgp_reader_t *r = *rp;
+
+  if (!r)
+    return;
+  if (r->fd == -1 && r->data)
+    munmap ((void *) r->data, r->maplen);
+  if (r->fd > 0)
+    close (r->fd);
+  safe_free (&r->buf);
+  safe_free (&r->pbuf);
+  safe_free (rp);
+}
+
+/*
+ * The n bytes from the next packet on, or NULL if the key ring ends
+ * before. On a stream this slides the window, which moves what
+ * earlier calls returned.
+ */
+static const unsigned char *pgp_peek (pgp_reader_t *r, size_t n)
+{
+  ssize_t got;
+
+  if (r->size - r->pos >= n)
+    return r->data + r->pos;
+  if (r->fd == -1 || r->eof)
+    return NULL;
 
-    if (!(p = realloc (pbuf, nplen)))	/* __MEM_CHECKED__ */
+  if (r->pos)
+  {
+    memmove (r->buf, r->buf + r->pos, r->size - r->pos);
+    r->offset += r->pos;
+    r->size -= r->pos;
+    r->pos = 0;
+  }
+  if (n > r->cap)
+  {
+    r->cap = n + WINDOWSIZE;
+    safe_realloc (&r->buf, r->cap);
+    r->data = r->buf;
+  }
+  while (r->size < n)
+  {
+    if ((got = read (r->fd, r->buf + r->size, r->cap - r->size)) > 0)
+      r->size += got;
+    else if (got == -1 && errno == EINTR)
+      continue;
+    else
     {
-      perror ("realloc");
-      return -1;
+      if (got == -1)
+	fprintf (stderr, "%s: %s\n", r->name, strerror (errno));
+      r->eof = 1;
+      return NULL;
     }
-    plen = nplen;
-    pbuf = p;
   }
+  return r->data;
+}
 
-  if (fread (pbuf + *used, 1, material, fp) < material)
+/* Append material bytes at p to the partial body buffer */
+static void add_material (pgp_reader_t *r, const unsigned char *p,
+			  size_t material, size_t *used)
+{
+  if (*used + material > r->plen)
   {
-    perror ("fread");
-    return -1;
+    r->plen = *used + material + CHUNKSIZE;
+    safe_realloc (&r->pbuf, r->plen);
   }
-
+  memcpy (r->pbuf + *used, p, material);
   *used += material;
-  return 0;
 }
 
-unsigned char *pgp_read_packet (FILE * fp, size_t * len)
+/* Number of length octets of a new style header, the first is c */
+static int new_length_octets (unsigned char c)
 {
-  size_t used = 0;
-  long startpos;
-  unsigned char ctb;
-  unsigned char b;
-  size_t material;
+  if (c < 192)
+    return 1;
+  if (c <= 223)
+    return 2;
+  if (c < 255)
+    return 1;
+  return 5;
+}
 
-  startpos = ftell (fp);
+/* The new style length at p; *partial tells if more pieces follow */
+static size_t new_length (const unsigned char *p, int *partial)
+{
+  size_t material;
 
-  if (!plen)
+  *partial = 0;
+  if (p[0] < 192)
+    return p[0];
+  if (p[0] <= 223)
+    return (p[0] - 192) * 256 + p[1] + 192;
+  if (p[0] < 255)
   {
-    plen = CHUNKSIZE;
-    pbuf = safe_malloc (plen);
+    *partial = 1;
+    return (size_t) 1 << (p[0] & 0x1f);
   }
+  material = (size_t) p[1] << 24;
+  material |= (size_t) p[2] << 16;
+  material |= (size_t) p[3] << 8;
+  material |= (size_t) p[4];
+  return material;
+}
 
-  if (fread (&ctb, 1, 1, fp) < 1)
+/* Number of length octets of an old style header, 0 if it has none */
+static int old_length_octets (unsigned char ctb)
+{
+  switch (ctb & 0x03)
   {
-    if (!feof (fp))
-      perror ("fread");
-    goto bail;
+    case 0: return 1;
+    case 1: return 2;
+    case 2: return 4;
+    default: return 0;
   }
+}
+
+static size_t old_length (const unsigned char *p, int bytes)
+{
+  size_t material = 0;
+
+  while (bytes-- > 0)
+    material = (material << 8) + *p++;
+  return material;
+}
+
+/*
+ * Read the next packet into pkt. Returns 0 at the end of the key
+ * ring, or where it stops making sense, and 1 otherwise.
+ */
+int pgp_read_packet (pgp_reader_t *r, pgp_packet_t *pkt)
+{
+  const unsigned char *d;
+  unsigned long start = r->offset + r->pos;
+  unsigned char ctb;
+  size_t material;
+  size_t off = 1;		/* header and body bytes so far */
+  size_t done = 0;		/* partial pieces already passed */
+  size_t body;
+  int bytes;
+
+  if ((d = pgp_peek (r, 1)) == NULL)
+    return 0;
 
+  ctb = d[0];
   if (!(ctb & 0x80))
-  {
-    goto bail;
-  }
+    return 0;
 
   if (ctb & 0x40)		/* handle PGP 5.0 packets. */
   {
     int partial = 0;
-    pbuf[0] = ctb;
-    used++;
+    size_t used = 0;
+
+    pkt->tag = ctb & 0x3f;
 
     do
     {
-      if (fread (&b, 1, 1, fp) < 1)
-      {
-	perror ("fread");
-	goto bail;
-      }
+      if ((d = pgp_peek (r, off + 1)) == NULL ||
+	  (d = pgp_peek (r, off + (bytes = new_length_octets (d[off])))) == NULL)
+	goto truncated;
+      material = new_length (d + off, &partial);
+      off += bytes;
 
-      if (b < 192)
-      {
-	material = b;
-	partial = 0;
-	/* material -= 1; */
-      }
-      else if (192 <= b && b <= 223)
-      {
-	material = (b - 192) * 256;
-	if (fread (&b, 1, 1, fp) < 1)
-	{
-	  perror ("fread");
-	  goto bail;
-	}
-	material += b + 192;
-	partial = 0;
-	/* material -= 2; */
-      }
-      else if (b < 255)
+      if ((d = pgp_peek (r, off + material)) == NULL)
+	goto truncated;
+
+      if (!partial && !used)
       {
-	material = 1 << (b & 0x1f);
-	partial = 1;
-	/* material -= 1; */
+	/* the whole body in one piece, nothing to copy */
+	pkt->body = d + off;
+	body = material;
       }
       else
-	/* b == 255 */
       {
-	unsigned char buf[4];
-	if (fread (buf, 4, 1, fp) < 1)
-	{
-	  perror ("fread");
-	  goto bail;
-	}
-	/*assert( sizeof(material) >= 4 ); */
-	material = buf[0] << 24;
-	material |= buf[1] << 16;
-	material |= buf[2] << 8;
-	material |= buf[3];
-	partial = 0;
-	/* material -= 5; */
+	add_material (r, d + off, material, &used);
+	pkt->body = r->pbuf;
+	body = used;
       }
+      off += material;
 
-      if (read_material (material, &used, fp) == -1)
-	goto bail;
-
+      if (partial)
+      {
+	/* that piece is copied, let the window move on */
+	r->pos += off;
+	done += off;
+	off = 0;
+      }
     }
     while (partial);
   }
   else
     /* Old-Style PGP */
   {
-    int bytes = 0;
-    pbuf[0] = 0x80 | ((ctb >> 2) & 0x0f);
-    used++;
-
-    switch (ctb & 0x03)
-    {
-      case 0:
-      {
-	if (fread (&b, 1, 1, fp) < 1)
-	{
-	  perror ("fread");
-	  goto bail;
-	}
-
-	material = b;
-	break;
-      }
+    pkt->tag = (ctb >> 2) & 0x0f;
+
+    if (!(bytes = old_length_octets (ctb)))
+      return 0;
+    if ((d = pgp_peek (r, off + bytes)) == NULL)
+      goto truncated;
+    material = old_length (d + off, bytes);
+    off += bytes;
+
+    if ((d = pgp_peek (r, off + material)) == NULL)
+      goto truncated;
+    pkt->body = d + off;
+    body = material;
+    off += material;
+  }
 
-      case 1:
-      bytes = 2;
+  pkt->len = body;
+  pkt->hdrlen = done + off - body;
+  r->pos += off;
+  return 1;
 
-      case 2:
-      {
-	int i;
+truncated:
 
-	if (!bytes)
-	  bytes = 4;
+  fprintf (stderr, "%s: truncated packet at offset %lu\n", r->name, start);
+  r->pos = r->size;
+  r->eof = 1;
+  return 0;
+}
 
-	material = 0;
+/*
+ * Find where the primary keys of a mapped key ring are, from its
+ * packet headers alone: packet bodies are skipped, not read. Stops
+ * where pgp_read_packet () would. Returns the number of offsets
+ * stored in *keys (to be freed), or -1 if r is not mapped.
+ */
+long pgp_index_keys (const pgp_reader_t *r, size_t **keys)
+{
+  const unsigned char *d = r->data;
+  size_t pos = r->pos, start, material;
+  size_t n = 0, cap = 0;
+  unsigned char ctb, tag;
+  int bytes, partial;
 
-	for (i = 0; i < bytes; i++)
-	{
-	  if (fread (&b, 1, 1, fp) < 1)
-	  {
-	    perror ("fread");
-	    goto bail;
-	  }
+  if (r->fd != -1)
+    return -1;
+  *keys = NULL;
 
-	  material = (material << 8) + b;
-	}
-	break;
+  while (pos < r->size && ((ctb = d[pos]) & 0x80))
+  {
+    start = pos++;
+    if (ctb & 0x40)
+    {
+      tag = ctb & 0x3f;
+      do
+      {
+	if (pos == r->size || r->size - pos < (size_t) (bytes = new_length_octets (d[pos])))
+	  return n;
+	material = new_length (d + pos, &partial);
+	pos += bytes;
+	if (r->size - pos < material)
+	  return n;
+	pos += material;
       }
-
-      default:
-      goto bail;
+      while (partial);
+    }
+    else
+    {
+      tag = (ctb >> 2) & 0x0f;
+      if (!(bytes = old_length_octets (ctb)) || r->size - pos < (size_t) bytes)
+	return n;
+      material = old_length (d + pos, bytes);
+      pos += bytes;
+      if (r->size - pos < material)
+	return n;
+      pos += material;
     }
 
-    if (read_material (material, &used, fp) == -1)
-      goto bail;
+    if (tag == PT_PUBKEY || tag == PT_SECKEY)
+    {
+      if (n == cap)
+      {
+	cap = cap ? 2 * cap : CHUNKSIZE;
+	safe_realloc (keys, cap * sizeof (size_t));
+      }
+      (*keys)[n++] = start;
+    }
   }
-
-  if (len)
-    *len = used;
-
-  return pbuf;
-
-bail:
-
-  fseek (fp, startpos, SEEK_SET);
-  return NULL;
+  return n;
 }
 
-void pgp_release_packet (void)
+/*
+ * Make a mapped reader read the packets from offset start up to end
+ * only. Both must be packet boundaries, e.g. from pgp_index_keys ().
+ */
+int pgp_set_range (pgp_reader_t *r, size_t start, size_t end)
 {
-  plen = 0;
-  safe_free (&pbuf);
+  if (r->fd != -1 || start > end || end > r->maplen)
+    return -1;
+  r->pos = start;
+  r->size = end;
+  return 0;
 }
-
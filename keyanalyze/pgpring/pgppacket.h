@@ -46,7 +46,48 @@ enum packet_tags
   PT_COMMENT			/* Comment Packet */
 };
 
-unsigned char *pgp_read_packet (FILE * fp, size_t * len);
-void pgp_release_packet (void);
+/*
+ * A packet as it lies in the key ring: the body points straight into
+ * the mapped file (or into the window onto a stream), except for
+ * packets with partial body lengths, whose pieces are put together in
+ * the reader's buffer. Either way it stays valid until the next
+ * pgp_read_packet () on the same reader.
+ */
+typedef struct pgp_packet
+{
+  unsigned char tag;		/* packet_tags */
+  size_t hdrlen;		/* header bytes, all length octets included */
+  const unsigned char *body;
+  size_t len;			/* body bytes */
+}
+pgp_packet_t;
+
+/*
+ * Regular files are mapped whole. Pipes, and anything else that
+ * cannot be mapped, are read through a window that slides along with
+ * the packets, so the reader never seeks.
+ */
+typedef struct pgp_reader
+{
+  const char *name;
+  const unsigned char *data;	/* the mapping or the window */
+  size_t size;			/* bytes at data, or up to the range end */
+  size_t maplen;		/* bytes mapped */
+  size_t pos;			/* next packet at data + pos */
+  size_t offset;		/* file offset of data[0] */
+  int fd;			/* stream, -1 if mapped */
+  short eof;
+  unsigned char *buf;		/* the window */
+  size_t cap;
+  unsigned char *pbuf;		/* bodies with partial lengths */
+  size_t plen;
+}
+pgp_reader_t;
+
+pgp_reader_t *pgp_open_reader (const char *name);
+void pgp_close_reader (pgp_reader_t **rp);
+int pgp_read_packet (pgp_reader_t *r, pgp_packet_t *pkt);
+long pgp_index_keys (const pgp_reader_t *r, size_t **keys);
+int pgp_set_range (pgp_reader_t *r, size_t start, size_t end);
 
 #endif
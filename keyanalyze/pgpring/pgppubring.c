@@ -42,7 +42,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #ifdef HAVE_GETOPT_H
 # include <getopt.h>
 #endif
@@ -56,22 +62,37 @@ extern int optind;
 #include "pgppacket.h"
 
 
-#ifdef HAVE_FGETPOS
-#define FGETPOS(fp,pos) fgetpos((fp),&(pos))
-#define FSETPOS(fp,pos) fsetpos((fp),&(pos))
-#else
-#define FGETPOS(fp,pos) pos=ftell((fp));
-#define FSETPOS(fp,pos) fseek((fp),(pos),SEEK_SET)
-#endif
-
-
 static short dump_signatures  = 0;
 static short exclude_exp_sigs = 0;
 static short exclude_exp_keys = 0;
 static short dump_subpackets  = 0;
 
-static void pgpring_find_candidates (char *ringfile, const char *hints[], int nhints);
-static void pgpring_dump_keyblock (pgp_key_t *p);
+/*
+ * Listings are formatted into a buffer of their own, which goes to
+ * fd with one write () whenever it is full, or with fd -1, grows to
+ * hold all of it.
+ */
+typedef struct pgpring_out
+{
+  char *buf;
+  size_t len;
+  size_t size;
+  int fd;
+  int err;			/* errno of a failed write */
+  long day;			/* the date last formatted, in days since 1970 */
+  char date[24];
+  int datelen;			/* 0 if there is none yet */
+}
+pgpring_out_t;
+
+static void pgpring_out_init (pgpring_out_t *out, int fd);
+static int pgpring_out_flush (pgpring_out_t *out);
+static int pgpring_find_candidates (const char *ringfile, size_t start, size_t end,
+				    pgpring_out_t *out, const char *hints[], int nhints);
+static void pgpring_dump_keyblock (pgpring_out_t *out, pgp_key_t *p);
+static void pgpring_add_rings (char ***rings, int *nrings, const char *name);
+static void pgpring_dump_rings (char **rings, int nrings, int nthreads,
+				const char *outdir, const char *hints[], int nhints);
 
 int main (int argc, char * const argv[])
 {
@@ -80,13 +101,18 @@ int main (int argc, char * const argv[])
   short version = 2;
   short secring = 0;
   
-  const char *_kring = NULL;
+  short _kring = 0;
   char *env_pgppath, *env_home;
+  char **rings = NULL;
+  int nrings = 0;
+  int nthreads = 1;
+  const char *outdir = NULL;
+  pgpring_out_t out;
 
   char pgppath[_POSIX_PATH_MAX];
   char kring[_POSIX_PATH_MAX];
 
-  while ((c = getopt (argc, argv, "PeE25sk:S")) != EOF)
+  while ((c = getopt (argc, argv, "PeE25sk:Sj:o:")) != EOF)
   {
     switch (c)
     {
@@ -112,7 +138,24 @@ int main (int argc, char * const argv[])
       }
       case 'k':
       {
-	_kring = optarg;
+	_kring = 1;
+	pgpring_add_rings (&rings, &nrings, optarg);
+	break;
+      }
+
+      case 'j':
+      {
+	if ((nthreads = atoi (optarg)) < 1)
+	{
+	  fprintf (stderr, "%s: need at least one thread\n", argv[0]);
+	  exit (1);
+	}
+	break;
+      }
+
+      case 'o':
+      {
+	outdir = optarg;
 	break;
       }
       
@@ -130,7 +173,7 @@ int main (int argc, char * const argv[])
     
       default:
       {
-	fprintf (stderr, "usage: %s [-k <key ring> | [-2 | -5] [ -s]] [hints]\n",
+	fprintf (stderr, "usage: %s [-k <key ring> ... | [-2 | -5] [ -s]] [-j <threads>] [-o <dir>] [hints]\n",
 		 argv[0]);
 	exit (1);
       }
@@ -138,7 +181,13 @@ int main (int argc, char * const argv[])
   }
 
   if (_kring)
-    strfcpy (kring, _kring, sizeof (kring));
+  {
+    if (!nrings)
+    {
+      fprintf (stderr, "%s: no key rings to dump.\n", argv[0]);
+      exit (1);
+    }
+  }
   else
   {
     if ((env_pgppath = getenv ("PGPPATH")))
@@ -155,9 +204,21 @@ int main (int argc, char * const argv[])
       snprintf (kring, sizeof (kring), "%s/secring.%s", pgppath, version == 2 ? "pgp" : "skr");
     else
       snprintf (kring, sizeof (kring), "%s/pubring.%s", pgppath, version == 2 ? "pgp" : "pkr");
+
+    pgpring_add_rings (&rings, &nrings, kring);
   }
   
-  pgpring_find_candidates (kring, (const char**) argv + optind, argc - optind);
+  if (nrings == 1 && nthreads == 1 && !outdir)
+  {
+    pgpring_out_init (&out, 1);
+    pgpring_find_candidates (rings[0], 0, 0, &out, (const char**) argv + optind, argc - optind);
+    if (pgpring_out_flush (&out) == -1)
+      perror ("write");
+    safe_free (&out.buf);
+  }
+  else
+    pgpring_dump_rings (rings, nrings, nthreads, outdir,
+			(const char**) argv + optind, argc - optind);
     
   return 0;
 }
@@ -165,7 +226,7 @@ int main (int argc, char * const argv[])
 
 /* The actual key ring parser */
 
-static pgp_key_t *pgp_parse_pgp2_key (unsigned char *buff, size_t l)
+static pgp_key_t *pgp_parse_pgp2_key (pgp_arena_t *a, const unsigned char *buff, size_t l)
 {
   pgp_key_t *p;
   unsigned char alg;
@@ -177,13 +238,13 @@ static pgp_key_t *pgp_parse_pgp2_key (unsigned char *buff, size_t l)
   int i, k;
   unsigned char scratch[LONG_STRING];
 
-  if (l < 12)
+  if (l < 11)
     return NULL;
 
-  p = pgp_new_keyinfo();
-  p->version = buff[1];
+  p = pgp_new_keyinfo (a);
+  p->version = buff[0];
 
-  for (i = 0, j = 2; i < 4; i++)
+  for (i = 0, j = 1; i < 4; i++)
     gen_time = (gen_time << 8) + buff[j++];
 
   p->gen_time = gen_time;
@@ -211,8 +272,8 @@ static pgp_key_t *pgp_parse_pgp2_key (unsigned char *buff, size_t l)
   p->keylen = expl;
 
   expl = (expl + 7) / 8;
-  if (expl < 4)
-    goto bailout;
+  if (expl < 4 || j + expl > l)
+    return NULL;
 
 
   j += expl - 8;
@@ -226,17 +287,13 @@ static pgp_key_t *pgp_parse_pgp2_key (unsigned char *buff, size_t l)
 	      "%08lX", id);
   }
 
-  p->keyid = safe_strdup ((char *) scratch);
+  p->keyid = pgp_arena_strdup (a, (char *) scratch);
 
   return p;
-
-bailout:
-
-  safe_free ((void *)&p);
-  return NULL;
 }
 
-static void pgp_make_pgp3_fingerprint (unsigned char *buff, size_t l,
+static void pgp_make_pgp3_fingerprint (unsigned char tag,
+				       const unsigned char *buff, size_t l,
 				       unsigned char *digest)
 {
   unsigned char dummy;
@@ -244,40 +301,46 @@ static void pgp_make_pgp3_fingerprint (unsigned char *buff, size_t l,
 
   SHA1_Init (&context);
 
-  dummy = buff[0] & 0x3f;
+  dummy = tag;
 
   if (dummy == PT_SUBSECKEY || dummy == PT_SUBKEY || dummy == PT_SECKEY)
     dummy = PT_PUBKEY;
 
   dummy = (dummy << 2) | 0x81;
   SHA1_Update (&context, &dummy, 1);
-  dummy = ((l - 1) >> 8) & 0xff;
+  dummy = (l >> 8) & 0xff;
   SHA1_Update (&context, &dummy, 1);
-  dummy = (l - 1) & 0xff;
+  dummy = l & 0xff;
   SHA1_Update (&context, &dummy, 1);
-  SHA1_Update (&context, buff + 1, l - 1);
+  SHA1_Update (&context, buff, l);
   SHA1_Final (digest, &context);
 
 }
 
-static void skip_bignum (unsigned char *buff, size_t l, size_t j,
-			 size_t * toff, size_t n)
+/* Skip n MPIs starting at j; -1 if they run past the l body bytes */
+static int skip_bignum (const unsigned char *buff, size_t l, size_t j,
+			size_t * toff, size_t n)
 {
   size_t len;
 
-  do
+  for (; n > 0; n--)
   {
+    if (j + 2 > l)
+      return -1;
     len = (buff[j] << 8) + buff[j + 1];
     j += (len + 7) / 8 + 2;
+    if (j > l)
+      return -1;
   }
-  while (j <= l && --n > 0);
 
   if (toff)
     *toff = j;
+  return 0;
 }
 
 
-static pgp_key_t *pgp_parse_pgp3_key (unsigned char *buff, size_t l)
+static pgp_key_t *pgp_parse_pgp3_key (pgp_arena_t *a, unsigned char tag,
+				       const unsigned char *buff, size_t l)
 {
   pgp_key_t *p;
   unsigned char alg;
@@ -289,10 +352,14 @@ static pgp_key_t *pgp_parse_pgp3_key (unsigned char *buff, size_t l)
   short len;
   size_t j;
 
-  p = pgp_new_keyinfo ();
-  p->version = buff[1];
+  /* version, creation time, algorithm and the first MPI's length */
+  if (l < 8)
+    return NULL;
 
-  j = 2;
+  p = pgp_new_keyinfo (a);
+  p->version = buff[0];
+
+  j = 1;
 
   for (i = 0; i < 4; i++)
     gen_time = (gen_time << 8) + buff[j++];
@@ -308,17 +375,23 @@ static pgp_key_t *pgp_parse_pgp3_key (unsigned char *buff, size_t l)
   len = (buff[j] << 8) + buff[j + 1];
   p->keylen = len;
 
-  if (alg == 17)
-    skip_bignum (buff, l, j, &j, 3);
-  else if (alg == 16 || alg == 20)
-    skip_bignum (buff, l, j, &j, 2);
-
   if (alg >= 1 && alg <= 3)
-    skip_bignum (buff, l, j, &j, 2);
-  else if (alg == 17 || alg == 16 || alg == 20)
-    skip_bignum (buff, l, j, &j, 1);
+  {
+    if (skip_bignum (buff, l, j, &j, 2) == -1)
+      return NULL;
+  }
+  else if (alg == 17)
+  {
+    if (skip_bignum (buff, l, j, &j, 4) == -1)
+      return NULL;
+  }
+  else if (alg == 16 || alg == 20)
+  {
+    if (skip_bignum (buff, l, j, &j, 3) == -1)
+      return NULL;
+  }
 
-  pgp_make_pgp3_fingerprint (buff, j, digest);
+  pgp_make_pgp3_fingerprint (tag, buff, j, digest);
 
   for (k = 0; k < 2; k++)
   {
@@ -328,7 +401,7 @@ static pgp_key_t *pgp_parse_pgp3_key (unsigned char *buff, size_t l)
     snprintf ((char *) scratch + k * 8, sizeof (scratch) - k * 8, "%08lX", id);
   }
 
-  p->keyid = safe_strdup ((char *) scratch);
+  p->keyid = pgp_arena_strdup (a, (char *) scratch);
   
   for (k = 0; k < 5; k++)
   {
@@ -338,29 +411,29 @@ static pgp_key_t *pgp_parse_pgp3_key (unsigned char *buff, size_t l)
     snprintf ((char *) scratch + k * 8, sizeof (scratch) - k * 8, "%08lX", id);
   }
 
-  p->fingerprint = safe_strdup ((char *) scratch);
+  p->fingerprint = pgp_arena_strdup (a, (char *) scratch);
 
   return p;
 }
 
-static pgp_key_t *pgp_parse_keyinfo (unsigned char *buff, size_t l)
+static pgp_key_t *pgp_parse_keyinfo (pgp_arena_t *a, const pgp_packet_t *pkt)
 {
-  if (!buff || l < 2)
+  if (pkt->len < 1)
     return NULL;
 
-  switch (buff[1])
+  switch (pkt->body[0])
   {
   case 2:
   case 3:
-    return pgp_parse_pgp2_key (buff, l);
+    return pgp_parse_pgp2_key (a, pkt->body, pkt->len);
   case 4:
-    return pgp_parse_pgp3_key (buff, l);
+    return pgp_parse_pgp3_key (a, pkt->tag, pkt->body, pkt->len);
   default:
     return NULL;
   }
 }
 
-static int pgp_parse_pgp2_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp_sig_t *s)
+static int pgp_parse_pgp2_sig (const unsigned char *buff, size_t l, pgp_key_t * p, pgp_sig_t *s)
 {
   unsigned char sigtype;
   time_t sig_gen_time;
@@ -371,10 +444,10 @@ static int pgp_parse_pgp2_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
   size_t j;
   int i;
 
-  if (l < 22)
+  if (l < 21)
     return -1;
 
-  j = 3;
+  j = 2;
   sigtype = buff[j++];
 
   sig_gen_time = 0;
@@ -398,7 +471,7 @@ static int pgp_parse_pgp2_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
 
   if (s)
   {
-    s->version  = buff[1];
+    s->version  = buff[0];
     s->sigtype  = sigtype;
     s->sid1     = signerid1;
     s->sid2     = signerid2;
@@ -410,7 +483,7 @@ static int pgp_parse_pgp2_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
   return 0;
 }
 
-static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp_sig_t *s)
+static int pgp_parse_pgp3_sig (pgp_arena_t *a, const unsigned char *buff, size_t l, pgp_key_t * p, pgp_sig_t *s)
 {
   unsigned char sigtype;
   unsigned char pkalg;
@@ -430,10 +503,10 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
   pgp_sig_subpk_t *subpackets = NULL;
   pgp_sig_subpk_t *sp = NULL;
 
-  if (l < 7)
+  if (l < 6)
     return -1;
 
-  j = 2;
+  j = 1;
 
   sigtype = buff[j++];
   pkalg = buff[j++];
@@ -444,6 +517,8 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
     size_t skl;
     size_t nextone;
 
+    if (j + 2 > l)
+      break;
     ml = (buff[j] << 8) + buff[j + 1];
     j += 2;
 
@@ -465,7 +540,8 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
 	  break;
       }
 
-      if ((int) ml - (int) skl < 0)
+      /* skl counts the type, so it is at least one */
+      if (skl == 0 || (int) ml - (int) skl < 0)
 	break;
       ml -= skl;
 
@@ -482,7 +558,7 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
       {
 	case 2:			/* creation time */
 	{
-	  if (skl < 4)
+	  if (skl < 5)
 	    break;
 	  sig_gen_time = 0;
 	  for (i = 0; i < 4; i++)
@@ -492,7 +568,7 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
 	}
 	case 3:			/* expiration time */
 	{
-	  if (skl < 4)
+	  if (skl < 5)
 	    break;
 	  validity = 0;
 	  for (i = 0; i < 4; i++)
@@ -501,7 +577,7 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
 	}
 	case 9:			/* key expiration time */
 	{
-	  if (skl < 4)
+	  if (skl < 5)
 	    break;
 	  key_validity = 0;
 	  for (i = 0; i < 4; i++)
@@ -513,7 +589,7 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
 	}
 	case 16:			/* issuer key ID */
 	{
-	  if (skl < 8)
+	  if (skl < 9)
 	    break;
 	  signerid2 = signerid1 = 0;
 	  for (i = 0; i < 4; i++)
@@ -537,12 +613,12 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
        sig_flags |= (1 << (skt & 0x7F));
        if (dump_subpackets)
        {
-           sp = safe_calloc (sizeof (pgp_sig_subpk_t), 1);
+           sp = pgp_arena_calloc (a, sizeof (pgp_sig_subpk_t));
            sp->next = subpackets;
            sp->type = skt & 0x7F;
            sp->len  = skl-1;
            sp->crit = skt & 0x80;
-           sp->data = safe_calloc (sizeof (char), skl);
+           sp->data = pgp_arena_calloc (a, skl);
            memcpy (sp->data, &(buff[j]), skl-1);
            
            subpackets = sp;
@@ -585,7 +661,7 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
 
   if (s)
   {
-    s->version = buff[1];
+    s->version = buff[0];
     s->sigtype = sigtype;
     s->sid1    = signerid1;
     s->sid2    = signerid2;
@@ -609,268 +685,771 @@ static int pgp_parse_pgp3_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp
 }
 
 
-static int pgp_parse_sig (unsigned char *buff, size_t l, pgp_key_t * p, pgp_sig_t *sig)
+static int pgp_parse_sig (pgp_arena_t *a, const pgp_packet_t *pkt, pgp_key_t * p, pgp_sig_t *sig)
 {
-  if (!buff || l < 2 || !p)
+  if (pkt->len < 1 || !p)
     return -1;
 
-  switch (buff[1])
+  switch (pkt->body[0])
   {
   case 2:
   case 3:
-    return pgp_parse_pgp2_sig (buff, l, p, sig);      
+    return pgp_parse_pgp2_sig (pkt->body, pkt->len, p, sig);      
   case 4:
-    return pgp_parse_pgp3_sig (buff, l, p, sig);
+    return pgp_parse_pgp3_sig (a, pkt->body, pkt->len, p, sig);
   default:
     return -1;
   }
 }
 
-/* parse one key block, including all subkeys. */
+static int pgpring_string_matches_hint (const char *s, const char *hints[], int nhints)
+{
+  int i;
 
-static pgp_key_t *pgp_parse_keyblock (FILE * fp)
+  if (!hints || !nhints)
+    return 1;
+
+  for (i = 0; i < nhints; i++)
+  {
+    if (mutt_stristr (s, hints[i]) != NULL)
+      return 1;
+  }
+
+  return 0;
+}
+
+/*
+ * A key block, including all subkeys, put together packet by packet
+ * as they are read, so every packet is parsed exactly once. All of
+ * it lives in the arena, which is reset once the block is done.
+ */
+typedef struct pgp_keyblock
 {
-  unsigned char *buff;
-  unsigned char pt = 0;
-  unsigned char last_pt;
-  size_t l;
-  short err = 0;
+  pgp_key_t *root;
+  pgp_key_t **last;
+  pgp_key_t *p;
+  pgp_uid_t *uid;
+  pgp_uid_t **addr;
+  pgp_sig_t **lsig;
+  unsigned char pt;		/* type of the last packet */
+  short err;			/* a key packet did not parse */
+  short match;			/* a user id matches the hints */
+  const char **hints;
+  int nhints;
+  pgpring_out_t *out;		/* where it is dumped */
+  pgp_arena_t *arena;
+}
+pgp_keyblock_t;
 
-#ifdef HAVE_FGETPOS
-  fpos_t pos;
-#else
-  long pos;
-#endif
+static void pgp_keyblock_init (pgp_keyblock_t *kb, pgp_arena_t *arena, pgpring_out_t *out,
+			       const char *hints[], int nhints)
+{
+  memset (kb, 0, sizeof (pgp_keyblock_t));
+  kb->arena = arena;
+  kb->last = &kb->root;
+  kb->hints = hints;
+  kb->nhints = nhints;
+  kb->out = out;
+}
 
-  pgp_key_t *root = NULL;
-  pgp_key_t **last = &root;
-  pgp_key_t *p = NULL;
-  pgp_uid_t *uid = NULL;
-  pgp_uid_t **addr = NULL;
-  pgp_sig_t **lsig = NULL;
+/* Add the next packet of the key block kb. */
 
-  FGETPOS(fp,pos);
-  
-  while (!err && (buff = pgp_read_packet (fp, &l)) != NULL)
-  {
-    last_pt = pt;
-    pt = buff[0] & 0x3f;
+static void pgp_keyblock_add (pgp_keyblock_t *kb, const pgp_packet_t *pkt)
+{
+  unsigned char last_pt;
+  pgp_key_t *p;
+  pgp_uid_t *uid;
 
-    /* check if we have read the complete key block. */
-    
-    if ((pt == PT_SECKEY || pt == PT_PUBKEY) && root)
+  /* 
+   * the rest of a broken key block is not looked at, but for
+   * whether it would have been dumped
+   */
+  if (kb->err)
+  {
+    if (pkt->tag == PT_NAME && !kb->match)
     {
-      FSETPOS(fp, pos);
-      return root;
+      char *chr = pgp_arena_malloc (kb->arena, pkt->len + 1);
+
+      memcpy (chr, pkt->body, pkt->len);
+      chr[pkt->len] = '\0';
+      kb->match = pgpring_string_matches_hint (chr, kb->hints, kb->nhints);
     }
-    
-    switch (pt)
-    {
-      case PT_SECKEY:
-      case PT_PUBKEY:
-      case PT_SUBKEY:
-      case PT_SUBSECKEY:
-      {
-	if (!(*last = p = pgp_parse_keyinfo (buff, l)))
-	{
-	  err = 1;
-	  break;
-	}
+    return;
+  }
 
-	last = &p->next;
-	addr = &p->address;
-	lsig = &p->sigs;
-	
-	if (pt == PT_SUBKEY || pt == PT_SUBSECKEY)
-	{
-	  p->flags |= KEYFLAG_SUBKEY;
-	  if (p != root)
-	  {
-	    p->parent  = root;
-	    p->address = pgp_copy_uids (root->address, p);
-	    while (*addr)
-	    	addr = &(*addr)->next;
-	  }
-	}
-	
-	if (pt == PT_SECKEY || pt == PT_SUBSECKEY)
-	  p->flags |= KEYFLAG_SECRET;
+  last_pt = kb->pt;
+  kb->pt = pkt->tag;
+  p = kb->p;
 
+  switch (pkt->tag)
+  {
+    case PT_SECKEY:
+    case PT_PUBKEY:
+    case PT_SUBKEY:
+    case PT_SUBSECKEY:
+    {
+      if (!(*kb->last = p = kb->p = pgp_parse_keyinfo (kb->arena, pkt)))
+      {
+	kb->err = 1;
 	break;
       }
 
-      case PT_SIG:
+      kb->last = &p->next;
+      kb->addr = &p->address;
+      kb->lsig = &p->sigs;
+      
+      if (pkt->tag == PT_SUBKEY || pkt->tag == PT_SUBSECKEY)
       {
-	if (lsig)
+	p->flags |= KEYFLAG_SUBKEY;
+	if (p != kb->root)
 	{
-	  pgp_sig_t *signature = safe_calloc (sizeof (pgp_sig_t), 1);
-	  *lsig = signature;
-	  lsig = &signature->next;
-	  
-	  pgp_parse_sig (buff, l, p, signature);
+	  p->parent  = kb->root;
+	  p->address = pgp_copy_uids (kb->arena, kb->root->address, p);
+	  while (*kb->addr)
+	    kb->addr = &(*kb->addr)->next;
 	}
-	break;
       }
+      
+      if (pkt->tag == PT_SECKEY || pkt->tag == PT_SUBSECKEY)
+	p->flags |= KEYFLAG_SECRET;
 
-      case PT_TRUST:
+      break;
+    }
+
+    case PT_SIG:
+    {
+      if (kb->lsig)
       {
-	if (p && (last_pt == PT_SECKEY || last_pt == PT_PUBKEY ||
-		  last_pt == PT_SUBKEY || last_pt == PT_SUBSECKEY))
-	{
-	  if (buff[1] & 0x20)
-	  {
-	    p->flags |= KEYFLAG_DISABLED;
-	  }
-	}
-	else if (last_pt == PT_NAME && uid)
+	pgp_sig_t *signature = pgp_arena_calloc (kb->arena, sizeof (pgp_sig_t));
+	*kb->lsig = signature;
+	kb->lsig = &signature->next;
+	
+	pgp_parse_sig (kb->arena, pkt, p, signature);
+      }
+      break;
+    }
+
+    case PT_TRUST:
+    {
+      if (pkt->len < 1)
+	break;
+      if (p && (last_pt == PT_SECKEY || last_pt == PT_PUBKEY ||
+		last_pt == PT_SUBKEY || last_pt == PT_SUBSECKEY))
+      {
+	if (pkt->body[0] & 0x20)
 	{
-	  uid->trust = buff[1];
+	  p->flags |= KEYFLAG_DISABLED;
 	}
-	break;
       }
-      case PT_NAME:
+      else if (last_pt == PT_NAME && kb->uid)
       {
-	char *chr;
+	kb->uid->trust = pkt->body[0];
+      }
+      break;
+    }
+    case PT_NAME:
+    {
+      char *chr;
 
 
-	if (!addr)
-	  break;
+      if (!kb->addr)
+	break;
 
-	chr = safe_malloc (l);
-	memcpy (chr, buff + 1, l - 1);
-	chr[l - 1] = '\0';
+      chr = pgp_arena_malloc (kb->arena, pkt->len + 1);
+      memcpy (chr, pkt->body, pkt->len);
+      chr[pkt->len] = '\0';
 
-	*addr = uid = safe_calloc (1, sizeof (pgp_uid_t)); /* XXX */
-	uid->addr = (unsigned char *)chr;
-	uid->parent = p;
-	uid->trust = 0;
-	addr = &uid->next;
-	lsig = &uid->sigs;
-	
-	/* the following tags are generated by
-	 * pgp 2.6.3in.
-	 */
+      *kb->addr = kb->uid = uid = pgp_arena_calloc (kb->arena, sizeof (pgp_uid_t));
+      uid->addr = (unsigned char *)chr;
+      uid->parent = p;
+      uid->trust = 0;
+      kb->addr = &uid->next;
+      kb->lsig = &uid->sigs;
+      
+      /* the following tags are generated by
+       * pgp 2.6.3in.
+       */
 
-	if (strstr (chr, "ENCR"))
-	  p->flags |= KEYFLAG_PREFER_ENCRYPTION;
-	if (strstr (chr, "SIGN"))
-	  p->flags |= KEYFLAG_PREFER_SIGNING;
+      if (strstr (chr, "ENCR"))
+	p->flags |= KEYFLAG_PREFER_ENCRYPTION;
+      if (strstr (chr, "SIGN"))
+	p->flags |= KEYFLAG_PREFER_SIGNING;
 
-	break;
-      }
-    }
+      /* mutt_decode_utf8_string (chr, chs); */
+
+      if (pgpring_string_matches_hint (chr, kb->hints, kb->nhints))
+	kb->match = 1;
 
-    FGETPOS(fp,pos);
+      break;
+    }
   }
+}
 
-  if (err)
-    pgp_free_key (&root);
-  
-  return root;  
+/*
+ * Dump the key block kb if one of its user ids matched, then start
+ * over with an empty one. Returns -1 if a matching key block did not
+ * parse: going on after that is not safe.
+ */
+
+static int pgp_keyblock_done (pgp_keyblock_t *kb)
+{
+  int rv = 0;
+
+  if (kb->match)
+  {
+    if (kb->err)
+      rv = -1;
+    else
+      pgpring_dump_keyblock (kb->out, kb->root);
+  }
+  pgp_arena_reset (kb->arena);
+  pgp_keyblock_init (kb, kb->arena, kb->out, kb->hints, kb->nhints);
+  return rv;
 }
 
-static int pgpring_string_matches_hint (const char *s, const char *hints[], int nhints)
+/* 
+ * Go through the key ring file and look for keys with
+ * matching IDs, which are dumped to out. If end is not 0,
+ * only the key blocks from offset start to end are read.
+ * Returns -1 if it stopped at a bad key block.
+ */
+
+static int pgpring_find_candidates (const char *ringfile, size_t start, size_t end,
+				    pgpring_out_t *out, const char *hints[], int nhints)
 {
-  int i;
+  pgp_reader_t *r;
+  pgp_packet_t pkt;
+  pgp_keyblock_t kb;
+  pgp_arena_t arena;
+  int rv = 0;
 
-  if (!hints || !nhints)
-    return 1;
+  if ((r = pgp_open_reader (ringfile)) == NULL)
+    return 0;
 
-  for (i = 0; i < nhints; i++)
+  if (end && pgp_set_range (r, start, end) == -1)
   {
-    if (mutt_stristr (s, hints[i]) != NULL)
-      return 1;
+    fprintf (stderr, "%s: can't read bytes %lu to %lu.\n", ringfile,
+	     (unsigned long) start, (unsigned long) end);
+    pgp_close_reader (&r);
+    return -1;
   }
 
-  return 0;
+  pgp_arena_init (&arena);
+  pgp_keyblock_init (&kb, &arena, out, hints, nhints);
+
+  while (pgp_read_packet (r, &pkt))
+  {
+    /* a new key block begins where a primary key does */
+    if ((pkt.tag == PT_SECKEY || pkt.tag == PT_PUBKEY) &&
+	(kb.root || kb.err) && (rv = pgp_keyblock_done (&kb)) == -1)
+      break;
+
+    pgp_keyblock_add (&kb, &pkt);
+  }
+  if (pgp_keyblock_done (&kb) == -1)
+    rv = -1;
+
+  pgp_arena_free (&arena);
+  pgp_close_reader (&r);
+
+  return rv;
 }
 
-/* 
- * Go through the key ring file and look for keys with
- * matching IDs.
+static int ringcmp (const void *a, const void *b)
+{
+  return strcmp (*(char * const *) a, *(char * const *) b);
+}
+
+/*
+ * Add the key ring name to rings, or if it is a directory, the *.pgp
+ * key rings in it (keydump-0001.pgp ...) in order of their names.
  */
 
-static void pgpring_find_candidates (char *ringfile, const char *hints[], int nhints)
+static void pgpring_add_rings (char ***rings, int *nrings, const char *name)
 {
-  FILE *rfp;
-#ifdef HAVE_FGETPOS
-  fpos_t pos, keypos;
-#else
-  long pos, keypos;
-#endif
+  struct stat st;
+  struct dirent *de;
+  DIR *dir;
+  char *path;
+  size_t l;
+  int first = *nrings;
 
-  unsigned char *buff = NULL;
-  unsigned char pt = 0;
-  size_t l = 0;
+  if (!strcmp (name, "-") || stat (name, &st) == -1 || !S_ISDIR (st.st_mode))
+  {
+    /* pgp_open_reader () complains if it is not there */
+    safe_realloc (rings, (*nrings + 1) * sizeof (char *));
+    (*rings)[(*nrings)++] = safe_strdup (name);
+    return;
+  }
 
-  short err = 0;
-  
-  if ((rfp = fopen (ringfile, "r")) == NULL)
+  if ((dir = opendir (name)) == NULL)
   {
-    perror ("fopen");
+    perror (name);
     return;
   }
+  while ((de = readdir (dir)) != NULL)
+  {
+    l = strlen (de->d_name);
+    if (de->d_name[0] == '.' || l < 5 || strcmp (de->d_name + l - 4, ".pgp"))
+      continue;
+    path = safe_malloc (strlen (name) + l + 2);
+    sprintf (path, "%s/%s", name, de->d_name);
+    safe_realloc (rings, (*nrings + 1) * sizeof (char *));
+    (*rings)[(*nrings)++] = path;
+  }
+  closedir (dir);
 
-  FGETPOS(rfp,pos);
-  FGETPOS(rfp,keypos);
+  qsort (*rings + first, *nrings - first, sizeof (char *), ringcmp);
+}
+
+/*
+ * Several key rings are dumped by a pool of threads, a job at a time
+ * each. A job is a key ring, or with more threads than that, a part
+ * of a big one: key rings of at least two times MINPART bytes are cut
+ * into parts of whole key blocks at the primary keys that
+ * pgp_index_keys () finds. A listing goes to outdir/<key ring>.txt, or
+ * into a buffer that is written out once all jobs before it are, so
+ * the output is the same as one pgpring after the other would give.
+ * So that the buffers do not pile up behind a slow job, the threads
+ * take no more than AHEAD jobs each past the first one not written.
+ */
+
+#ifndef MINPART
+#define MINPART (16 << 20)
+#endif
+
+#define AHEAD 2
 
-  while (!err && (buff = pgp_read_packet (rfp, &l)) != NULL)
+typedef struct pgpring_job
+{
+  const char *ring;
+  size_t start;			/* the part of ring, end 0 for all of it */
+  size_t end;
+  int part;
+  int nparts;
+  char *buf;			/* the listing, if not written to outdir */
+  size_t len;
+  short done;
+  short stopped;		/* at a bad key block */
+}
+pgpring_job_t;
+
+typedef struct pgpring_pool
+{
+  pgpring_job_t *jobs;
+  int njobs;
+  int next;			/* the next job to take */
+  int written;			/* the jobs before this are written out */
+  int ahead;			/* how far next may be past written */
+  const char *outdir;
+  const char **hints;
+  int nhints;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;		/* another job is done */
+  pthread_cond_t room;		/* written has moved on */
+}
+pgpring_pool_t;
+
+static char *pgpring_outfile (const char *outdir, const char *ring)
+{
+  const char *base;
+  char *path;
+
+  base = strrchr (ring, '/') ? strrchr (ring, '/') + 1 : ring;
+  path = safe_malloc (strlen (outdir) + strlen (base) + 6);
+  sprintf (path, "%s/%s.txt", outdir, base);
+  return path;
+}
+
+static void *pgpring_worker (void *arg)
+{
+  pgpring_pool_t *pool = arg;
+  pgpring_job_t *job;
+  pgpring_out_t out;
+  char *path = NULL;
+  int fd = -1;
+  short stopped = 0;
+
+  for (;;)
   {
-    pt = buff[0] & 0x3f;
-    
-    if (l < 1)
-      continue;
-    
-    if ((pt == PT_SECKEY) || (pt == PT_PUBKEY))
+    pthread_mutex_lock (&pool->lock);
+    while (pool->next < pool->njobs && pool->next - pool->written >= pool->ahead)
+      pthread_cond_wait (&pool->room, &pool->lock);
+    job = (pool->next < pool->njobs) ? &pool->jobs[pool->next++] : NULL;
+    pthread_mutex_unlock (&pool->lock);
+    if (!job)
+      break;
+
+    /* parts of a key ring are put together by pgpring_dump_rings () */
+    if (pool->outdir && job->nparts == 1)
     {
-      keypos = pos;
+      path = pgpring_outfile (pool->outdir, job->ring);
+      if ((fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1)
+	perror (path);
     }
-    else if (pt == PT_NAME)
+
+    if (!path || fd != -1)
     {
-      char *tmp = safe_malloc (l);
+      pgpring_out_init (&out, fd);
+      stopped = pgpring_find_candidates (job->ring, job->start, job->end, &out,
+					 pool->hints, pool->nhints) == -1;
+      if (fd == -1)
+      {
+	job->buf = out.buf;
+	job->len = out.len;
+      }
+      else
+      {
+	if (pgpring_out_flush (&out) == -1 || close (fd) == -1)
+	  perror (path);
+	safe_free (&out.buf);
+	fd = -1;
+      }
+    }
+    safe_free (&path);
 
-      memcpy (tmp, buff + 1, l - 1);
-      tmp[l - 1] = '\0';
+    pthread_mutex_lock (&pool->lock);
+    job->stopped = stopped;
+    job->done = 1;
+    pthread_cond_broadcast (&pool->cond);
+    pthread_mutex_unlock (&pool->lock);
+  }
 
-      /* mutt_decode_utf8_string (tmp, chs); */
+  return NULL;
+}
 
-      if (pgpring_string_matches_hint (tmp, hints, nhints))
+/*
+ * Add the jobs for the key ring ring to the pool: one for all of it,
+ * or if it is big enough, up to nparts of about the same size.
+ */
+
+static void pgpring_add_jobs (pgpring_pool_t *pool, const char *ring, int nparts)
+{
+  pgpring_job_t *job;
+  pgp_reader_t *r;
+  struct stat st;
+  size_t *keys = NULL, *cut;
+  long nkeys, k = 0;
+  int i, n = 1;
+
+  cut = safe_calloc (nparts + 1, sizeof (size_t));
+
+  if (nparts > 1 && strcmp (ring, "-") && stat (ring, &st) == 0 &&
+      S_ISREG (st.st_mode) && st.st_size / MINPART >= 2 &&
+      (r = pgp_open_reader (ring)) != NULL)
+  {
+    if (st.st_size / MINPART < nparts)
+      nparts = st.st_size / MINPART;
+
+    /* cut at the first primary key after every nparts'th of the file */
+    if ((nkeys = pgp_index_keys (r, &keys)) > 0)
+    {
+      for (i = 1; i < nparts; i++)
       {
-	pgp_key_t *p;
+	while (k < nkeys && keys[k] < r->size / nparts * i)
+	  k++;
+	if (k == nkeys)
+	  break;
+	if (keys[k] > cut[n - 1])
+	  cut[n++] = keys[k];
+      }
+      /* the last part goes on to the end, whatever is there */
+      cut[n] = r->size;
+    }
+    safe_free (&keys);
+    pgp_close_reader (&r);
+  }
 
-	FSETPOS(rfp, keypos);
+  safe_realloc (&pool->jobs, (pool->njobs + n) * sizeof (pgpring_job_t));
+  for (i = 0; i < n; i++)
+  {
+    job = &pool->jobs[pool->njobs++];
+    memset (job, 0, sizeof (pgpring_job_t));
+    job->ring = ring;
+    job->start = cut[i];
+    job->end = n > 1 ? cut[i + 1] : 0;
+    job->part = i;
+    job->nparts = n;
+  }
 
-	/* Not bailing out here would lead us into an endless loop. */
+  safe_free (&cut);
+}
 
-	if ((p = pgp_parse_keyblock (rfp)) == NULL)
-	  err = 1;
-	
-	pgpring_dump_keyblock (p);
-	pgp_free_key (&p);
+static void pgpring_dump_rings (char **rings, int nrings, int nthreads,
+				const char *outdir, const char *hints[], int nhints)
+{
+  pgpring_pool_t pool;
+  pgpring_job_t *job;
+  pthread_t *threads;
+  char *path = NULL;
+  FILE *out = stdout;
+  short stopped = 0;
+  int i, err;
+
+  memset (&pool, 0, sizeof (pool));
+  pool.outdir = outdir;
+  pool.hints = hints;
+  pool.nhints = nhints;
+  pthread_mutex_init (&pool.lock, NULL);
+  pthread_cond_init (&pool.cond, NULL);
+  pthread_cond_init (&pool.room, NULL);
+  for (i = 0; i < nrings; i++)
+    pgpring_add_jobs (&pool, rings[i], nthreads > nrings ? nthreads : 1);
+
+  if (nthreads > pool.njobs)
+    nthreads = pool.njobs;
+  pool.ahead = AHEAD * nthreads;
+  threads = safe_calloc (nthreads, sizeof (pthread_t));
+  for (i = 0; i < nthreads; i++)
+  {
+    if ((err = pthread_create (&threads[i], NULL, pgpring_worker, &pool)) != 0)
+    {
+      fprintf (stderr, "pthread_create: %s\n", strerror (err));
+      exit (1);
+    }
+  }
+
+  /* 
+   * write the listings out in order, as they come in; the parts of a
+   * key ring after one that stopped at a bad key block are dropped,
+   * as a single pgpring would not have got there.
+   */
+  for (i = 0; i < pool.njobs; i++)
+  {
+    /* the threads may go on AHEAD jobs each past this one */
+    pthread_mutex_lock (&pool.lock);
+    pool.written = i;
+    pthread_cond_broadcast (&pool.room);
+    pthread_mutex_unlock (&pool.lock);
+
+    job = &pool.jobs[i];
+    if (outdir && job->nparts == 1)
+      continue;
+
+    pthread_mutex_lock (&pool.lock);
+    while (!job->done)
+      pthread_cond_wait (&pool.cond, &pool.lock);
+    pthread_mutex_unlock (&pool.lock);
+
+    if (job->part == 0)
+    {
+      stopped = 0;
+      if (outdir)
+      {
+	path = pgpring_outfile (outdir, job->ring);
+	if ((out = fopen (path, "w")) == NULL)
+	  perror (path);
       }
+    }
+
+    if (out && !stopped)
+    {
+      fwrite (job->buf, 1, job->len, out);
+      stopped = job->stopped;
+    }
+    safe_free (&job->buf);
 
-      safe_free (&tmp);
+    if (outdir && job->part == job->nparts - 1)
+    {
+      if (out && fclose (out) == EOF)
+	perror (path);
+      safe_free (&path);
     }
+  }
+
+  for (i = 0; i < nthreads; i++)
+    pthread_join (threads[i], NULL);
+
+  pthread_mutex_destroy (&pool.lock);
+  pthread_cond_destroy (&pool.cond);
+  pthread_cond_destroy (&pool.room);
+  safe_free (&threads);
+  safe_free (&pool.jobs);
+}
 
-    FGETPOS(rfp,pos);
+/* The output buffer, and the formatting done into it */
+
+#define OUTBUFSIZE (1 << 20)
+
+static const char hexdigits[] = "0123456789ABCDEF";
+static const char lchexdigits[] = "0123456789abcdef";
+
+static void pgpring_out_init (pgpring_out_t *out, int fd)
+{
+  memset (out, 0, sizeof (pgpring_out_t));
+  out->size = OUTBUFSIZE;
+  out->buf = safe_malloc (out->size);
+  out->fd = fd;
+}
+
+/* 
+ * Write out what is in the buffer. Returns -1, with errno set, if
+ * that or an earlier flush failed; what follows is thrown away.
+ */
+static int pgpring_out_flush (pgpring_out_t *out)
+{
+  size_t done = 0;
+  ssize_t n;
+
+  if (out->fd == -1)
+    return 0;
+
+  while (done < out->len && !out->err)
+  {
+    if ((n = write (out->fd, out->buf + done, out->len - done)) != -1)
+      done += n;
+    else if (errno != EINTR)
+      out->err = errno;
+  }
+  out->len = 0;
+
+  if (out->err)
+  {
+    errno = out->err;
+    return -1;
+  }
+  return 0;
+}
+
+/* Make room for n more bytes */
+static void out_room (pgpring_out_t *out, size_t n)
+{
+  if (out->len + n <= out->size)
+    return;
+  pgpring_out_flush (out);
+  if (out->len + n > out->size)
+  {
+    while (out->len + n > out->size)
+      out->size *= 2;
+    safe_realloc (&out->buf, out->size);
+  }
+}
+
+static void out_char (pgpring_out_t *out, char c)
+{
+  out_room (out, 1);
+  out->buf[out->len++] = c;
+}
+
+static void out_str (pgpring_out_t *out, const char *s)
+{
+  size_t l = strlen (s);
+
+  out_room (out, l);
+  memcpy (out->buf + out->len, s, l);
+  out->len += l;
+}
+
+/* v in hex, zero padded to at least digits digits */
+static void out_hex (pgpring_out_t *out, unsigned long v, int digits, const char *hex)
+{
+  char tmp[2 * sizeof (unsigned long)];
+  int n = 0;
+
+  do
+  {
+    tmp[n++] = hex[v & 0xf];
+    v >>= 4;
+  }
+  while (v || n < digits);
+
+  out_room (out, n);
+  while (n)
+    out->buf[out->len++] = tmp[--n];
+}
+
+/* Put v in decimal, zero padded to at least digits digits, at p */
+static int fmt_dec (char *p, unsigned long v, int digits)
+{
+  char tmp[3 * sizeof (unsigned long)];
+  int n = 0, l = 0;
+
+  do
+  {
+    tmp[n++] = '0' + v % 10;
+    v /= 10;
   }
+  while (v || n < digits);
+
+  while (n)
+    p[l++] = tmp[--n];
+  return l;
+}
 
-  fclose (rfp);
+/* v in decimal, as %d does it */
+static void out_dec (pgpring_out_t *out, long v)
+{
+  out_room (out, 3 * sizeof (long) + 1);
+  if (v < 0)
+  {
+    out->buf[out->len++] = '-';
+    out->len += fmt_dec (out->buf + out->len, - (unsigned long) v, 1);
+  }
+  else
+    out->len += fmt_dec (out->buf + out->len, v, 1);
+}
+
+/* 
+ * t as YYYY-MM-DD, UTC. Many signatures in a row are from the same
+ * day, so the last date is kept; others are worked out from the
+ * day number instead of with gmtime ().
+ */
+static void out_date (pgpring_out_t *out, time_t t)
+{
+  long day, era, doe, yoe, doy, mp, y, m, d;
+  char *p;
+
+  day = t / 86400 - (t % 86400 < 0);
+  if (day != out->day || !out->datelen)
+  {
+    /* the proleptic Gregorian calendar, in eras of 400 years */
+    day += 719468;
+    era = (day >= 0 ? day : day - 146096) / 146097;
+    doe = day - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = yoe + era * 400 + (m <= 2);
+
+    p = out->date;
+    if (y < 0)
+    {
+      *p++ = '-';
+      p += fmt_dec (p, - (unsigned long) y, 3);
+    }
+    else
+      p += fmt_dec (p, y, 4);
+    *p++ = '-';
+    p += fmt_dec (p, m, 2);
+    *p++ = '-';
+    p += fmt_dec (p, d, 2);
+
+    out->datelen = p - out->date;
+    out->day = t / 86400 - (t % 86400 < 0);
+  }
 
+  out_room (out, out->datelen);
+  memcpy (out->buf + out->len, out->date, out->datelen);
+  out->len += out->datelen;
 }
 
-static void print_userid (const unsigned char *id)
+static void print_userid (pgpring_out_t *out, const unsigned char *id)
 {
   for (; id && *id; id++)
   {
     if (*id >= ' ' && *id <= 'z' && *id != ':')
-      putchar (*id);
+      out_char (out, *id);
     else
-      printf ("\\x%02x", *id);
+    {
+      out_str (out, "\\x");
+      out_hex (out, *id, 2, lchexdigits);
+    }
   }
 }
 
-static void print_subpacket (const pgp_sig_subpk_t *sp)
+static void print_subpacket (pgpring_out_t *out, const pgp_sig_subpk_t *sp)
 {
     unsigned short i;
     unsigned char *data;
@@ -880,7 +1459,13 @@ static void print_subpacket (const pgp_sig_subpk_t *sp)
     if (sp->crit)
     	flags |= 2;
     
-    printf ("spk:%d:%d:%d:", sp->type, flags, sp->len);
+    out_str (out, "spk:");
+    out_dec (out, (int) sp->type);
+    out_char (out, ':');
+    out_dec (out, flags);
+    out_char (out, ':');
+    out_dec (out, (int) sp->len);
+    out_char (out, ':');
     if (sp->data)
     {
        data = (unsigned char *)sp->data;
@@ -888,19 +1473,19 @@ static void print_subpacket (const pgp_sig_subpk_t *sp)
        {
            c = data[i];
            if (c >= ' ' && c <= 'z' && c != ':')
-              putchar (c);
+              out_char (out, c);
            else
-              printf ("\\x%02X", c);
+           {
+              out_str (out, "\\x");
+              out_hex (out, c, 2, hexdigits);
+           }
        }
     }
-    printf ("\n");
+    out_char (out, '\n');
 }
 
-static void pgpring_dump_signatures (pgp_sig_t *sig)
+static void pgpring_dump_signatures (pgpring_out_t *out, pgp_sig_t *sig)
 {
-  struct tm *tp;
-  time_t t;
-  
   for (; sig; sig = sig->next)
   {
     if (exclude_exp_sigs && (sig->flags & SIGFLAG_EXPIRED))
@@ -908,48 +1493,64 @@ static void pgpring_dump_signatures (pgp_sig_t *sig)
 
     if (sig->sigtype >= 0x10 && sig->sigtype <= 0x13)
     {
-      printf ("sig:%08lX%08lX:", sig->sid1, sig->sid2);
+      out_str (out, "sig:");
+      out_hex (out, sig->sid1, 8, hexdigits);
+      out_hex (out, sig->sid2, 8, hexdigits);
+      out_char (out, ':');
       
-      t = sig->gen_time;
-      tp = gmtime (&t);
-      printf ("%04d-%02d-%02d:", 1900 + tp->tm_year, tp->tm_mon + 1, tp->tm_mday);
+      out_date (out, sig->gen_time);
+      out_char (out, ':');
       
-      if (sig->exp_time) {
-          t = sig->exp_time;
-          tp = gmtime (&t);
-          printf ("%04d-%02d-%02d", 1900 + tp->tm_year, tp->tm_mon + 1, tp->tm_mday);
-      }
+      if (sig->exp_time)
+          out_date (out, sig->exp_time);
 
       //printf ("::::%X:", sig->sigtype);
-      printf (":%X:", sig->sigtype);
+      out_char (out, ':');
+      out_hex (out, sig->sigtype, 1, hexdigits);
+      out_char (out, ':');
 
       if (sig->flags & SIGFLAG_HAS_NOTATION)
-         putchar ('N');
+         out_char (out, 'N');
       if (sig->flags & SIGFLAG_CRITICAL)
-         putchar ('C');
+         out_char (out, 'C');
       if (sig->flags & SIGFLAG_HAS_POLICY)
-         putchar ('P');
+         out_char (out, 'P');
       if (sig->flags & SIGFLAG_PRIMARY_UID)
-         putchar ('p');
+         out_char (out, 'p');
       if (sig->flags & SIGFLAG_EXPIRED)
-         putchar ('e');
-
-      printf (":%d:%d:%d\n", sig->version, sig->pkalg, sig->hashalg);
+         out_char (out, 'e');
+
+      out_char (out, ':');
+      out_dec (out, sig->version);
+      out_char (out, ':');
+      out_dec (out, sig->pkalg);
+      out_char (out, ':');
+      out_dec (out, sig->hashalg);
+      out_char (out, '\n');
       if (dump_subpackets && sig->subpackets)
       {
           pgp_sig_subpk_t *sp;
           for (sp = sig->subpackets; sp; sp = sp->next)
-              print_subpacket (sp);
+              print_subpacket (out, sp);
       }
     }
     else if (sig->sigtype == 0x20 || sig->sigtype == 0x28 || sig->sigtype == 0x30) {
-	  printf ("rev:%08lX%08lX:", sig->sid1, sig->sid2);
-      t = sig->gen_time;
-      tp = gmtime (&t);
-      printf ("%04d-%02d-%02d:", 1900 + tp->tm_year, tp->tm_mon + 1, tp->tm_mday);
-      printf (":%X:", sig->sigtype);     
+      out_str (out, "rev:");
+      out_hex (out, sig->sid1, 8, hexdigits);
+      out_hex (out, sig->sid2, 8, hexdigits);
+      out_char (out, ':');
+      out_date (out, sig->gen_time);
+      out_str (out, "::");
+      out_hex (out, sig->sigtype, 1, hexdigits);
+      out_char (out, ':');
       /* Flags ? */
-      printf (":%d:%d:%d\n", sig->version, sig->pkalg, sig->hashalg); 
+      out_char (out, ':');
+      out_dec (out, sig->version);
+      out_char (out, ':');
+      out_dec (out, sig->pkalg);
+      out_char (out, ':');
+      out_dec (out, sig->hashalg);
+      out_char (out, '\n');
 	}
   }
 }
@@ -966,12 +1567,10 @@ static char gnupg_trustletter (int t)
   return 'q';
 }
 
-static void pgpring_dump_keyblock (pgp_key_t *p)
+static void pgpring_dump_keyblock (pgpring_out_t *out, pgp_key_t *p)
 {
   pgp_uid_t *uid;
   short first;
-  struct tm *tp;
-  time_t t;
   
   for (; p; p = p->next)
   {
@@ -983,55 +1582,63 @@ static void pgpring_dump_keyblock (pgp_key_t *p)
     if (p->flags & KEYFLAG_SECRET)
     {
       if (p->flags & KEYFLAG_SUBKEY)
-         printf ("ssb:");
+         out_str (out, "ssb:");
       else
-         printf ("sec:");
+         out_str (out, "sec:");
     }
     else 
     {
       if (p->flags & KEYFLAG_SUBKEY)
-         printf ("sub:");
+         out_str (out, "sub:");
       else
-         printf ("pub:");
+         out_str (out, "pub:");
     }
     
     if (p->flags & KEYFLAG_REVOKED)
-      putchar ('r');
+      out_char (out, 'r');
     if (p->flags & KEYFLAG_EXPIRED)
-      putchar ('e');
+      out_char (out, 'e');
     if (p->flags & KEYFLAG_DISABLED)
-      putchar ('d');
+      out_char (out, 'd');
       
 	if (p->flags & KEYFLAG_SECRET)
-	  putchar ('u');
+	  out_char (out, 'u');
 	else
-	  putchar (gnupg_trustletter (p->address->trust));
+	  out_char (out, gnupg_trustletter (p->address->trust));
 	  
-	t = p->gen_time;
-	tp = gmtime (&t);
-
-	printf (":%d:%d:%s:%04d-%02d-%02d:", p->keylen, p->numalg, p->keyid,
-		1900 + tp->tm_year, tp->tm_mon + 1, tp->tm_mday);
-    if (p->exp_time)
-    {
-        t = p->exp_time;
-        tp = gmtime (&t);
-        printf ("%04d-%02d-%02d", 1900 + tp->tm_year, tp->tm_mon + 1, tp->tm_mday);
-    }
-	printf (":%d:\n", p->version);
+	out_char (out, ':');
+	out_dec (out, p->keylen);
+	out_char (out, ':');
+	out_dec (out, p->numalg);
+	out_char (out, ':');
+	out_str (out, p->keyid);
+	out_char (out, ':');
+	out_date (out, p->gen_time);
+	out_char (out, ':');
+	if (p->exp_time)
+	  out_date (out, p->exp_time);
+	out_char (out, ':');
+	out_dec (out, p->version);
+	out_str (out, ":\n");
 	
 	if (p->fingerprint && !(p->flags & KEYFLAG_SUBKEY))
-		printf ("fpr:::::::::%s:\n", p->fingerprint);
+	{
+		out_str (out, "fpr:::::::::");
+		out_str (out, p->fingerprint);
+		out_str (out, ":\n");
+	}
 
     for (uid = p->address; uid; uid = uid->next, first = 0)
     {
-         printf ("uid:%c::::::::", gnupg_trustletter (uid->trust));
-         print_userid (uid->addr);
-         printf (":\n");
+         out_str (out, "uid:");
+         out_char (out, gnupg_trustletter (uid->trust));
+         out_str (out, "::::::::");
+         print_userid (out, uid->addr);
+         out_str (out, ":\n");
          if (dump_signatures)
          {
-             if (first) pgpring_dump_signatures (p->sigs);
-             pgpring_dump_signatures (uid->sigs);
+             if (first) pgpring_dump_signatures (out, p->sigs);
+             pgpring_dump_signatures (out, uid->sigs);
          }
     }
 	
@@ -24,9 +24,7 @@ CENTRALITY=$PREFIX/wot-centrality
 
 OUTDIR=$1
 
-echo "Running keyanalyze"
-time $KEYANALYZE -N -n -i $OUTDIR/preprocessed.ka -o $OUTDIR
+# keyanalyze streams the strong set straight into wot-centrality
+echo "Running keyanalyze and wot-centrality"
+time $KEYANALYZE -N -s -i $OUTDIR/preprocessed.ka -o $OUTDIR | $CENTRALITY -s > $OUTDIR/centrality.csv
 #$GREP -e '^\*\*\*' $OUTDIR/othersets.txt | $CUT -d' ' -f2 | $SORT -rn >$OUTDIR/sets_size.txt
-
-echo "Running wot-centrality"
-time $CENTRALITY $OUTDIR/preprocessed.strongset > $OUTDIR/centrality.csv
@@ -28,12 +28,11 @@ if [ ! -e $OUTDIR ]; then
     mkdir -p $OUTDIR
 fi
 
-echo -n > $OUTDIR/pgpring.dump
+# one thread per core; the dump still comes out in file name order
+JOBS=${JOBS:-$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)}
 
-for k in $DUMPDIR/*.pgp; do
-   echo Processing $k
-   $PGPRING -PS -k $k >> $OUTDIR/pgpring.dump
-done
+echo Processing $DUMPDIR/*.pgp with $JOBS threads
+$PGPRING -PS -j $JOBS -k $DUMPDIR > $OUTDIR/pgpring.dump
 
 echo "Preprocessing keys"
 $PROCESSKEYS $OUTDIR
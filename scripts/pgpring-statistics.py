@@ -320,6 +320,7 @@ for line in infiles['msd.csv']:
 			'eccentricity'  : eccentricity,
 			'centrality_abs': 0.0,
 			'centrality_rel': 0.0,
+			'bridge'        : 0.0,
 			'clustering': 0.0
 		}
 		matrix[keyid] = {'in': set(), 'out': set(), 'all': set()}
@@ -380,7 +381,9 @@ infiles['msd.csv'].close()
 # Read centrality
 max_centrality = -1.0
 for line in infiles['centrality.csv']:
-	keyid, centrality = line.strip().split(';')
+	# keyid;betweenness;bridge centrality
+	fields = line.strip().split(';')
+	keyid, centrality = fields[0], fields[1]
 	if keyid not in strong_set:
 		print >>sys.stderr, "Something wrong with key %s" % keyid
 	centrality = float(centrality)
@@ -389,6 +392,8 @@ for line in infiles['centrality.csv']:
 		
 	strong_set_data[keyid]['centrality_abs'] = centrality
 	strong_set_data[keyid]['centrality_rel'] = centrality/((strong_set_size-1)*(strong_set_size-2))
+	if len(fields) > 2:
+		strong_set_data[keyid]['bridge'] = float(fields[2])
 	
 # Calculate graph centralization
 centr_sum = 0.0
@@ -510,11 +515,11 @@ print "Global clustering coefficient: %.5f" % (global_tot / strong_set_size)
 infiles['preprocessed'].close()
 matrix = None
 
-fields = ('keyid','msd','in_degree','out_degree','cross_degree','eccentricity','centrality_abs','centrality_rel','clustering')
+fields = ('keyid','msd','in_degree','out_degree','cross_degree','eccentricity','centrality_abs','centrality_rel','bridge','clustering')
 print >>outfiles['strongset.csv'], ';'.join (fields)
 for k in strong_set_data:
 	kd = strong_set_data[k]
-	print >>outfiles['strongset.csv'], "%(keyid)s;%(msd).5f;%(in_degree)d;%(out_degree)d;%(cross_degree)d;%(eccentricity)d;%(centrality_abs).9f;%(centrality_rel).9f;%(clustering).5f" % kd
+	print >>outfiles['strongset.csv'], "%(keyid)s;%(msd).5f;%(in_degree)d;%(out_degree)d;%(cross_degree)d;%(eccentricity)d;%(centrality_abs).9f;%(centrality_rel).9f;%(bridge).9f;%(clustering).5f" % kd
 	
 outfiles['strongset.csv'].close()
 
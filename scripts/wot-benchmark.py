@@ -0,0 +1,183 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+End-to-end benchmark of process_keys, keyanalyze and wot-centrality
+on synthetic webs of trust (see utils/generate-wot.py).
+
+For every size the whole pipeline is run on a freshly generated
+keyring dump; every tool is timed as a whole and per phase (the
+"<phase> took <n> seconds" lines the tools log). Results are printed
+next to the figures of a baseline file, which is written instead when
+-w is given.
+
+Baseline format (one measurement per line):
+    <keys>;<tool>;<phase>;<seconds>
+"""
+
+from __future__ import print_function
+
+import sys
+import os
+import re
+import getopt
+import subprocess
+import time
+
+topdir = os.path.abspath (os.path.join (os.path.dirname (__file__), '..'))
+
+tools = {
+	'process_keys'   : os.path.join (topdir, 'keyanalyze', 'process_keys'),
+	'keyanalyze'     : os.path.join (topdir, 'keyanalyze', 'keyanalyze'),
+	'wot-centrality' : os.path.join (topdir, 'Cwot', 'wot-centrality')
+}
+generator = os.path.join (topdir, 'utils', 'generate-wot.py')
+
+phase_re = re.compile (r'^(.*) took ([0-9.]+) seconds$')
+
+def usage ():
+	print ("usage: %s [-s sizes] [-b baseline] [-w] [-d workdir] [-S seed] "
+	       "[-k keyanalyze] [-p process_keys] [-c wot-centrality] "
+	       "[-W wot-centrality options]" % sys.argv[0], file=sys.stderr)
+	sys.exit (1)
+
+def phases (lines):
+	for line in lines:
+		m = phase_re.match (line.strip ())
+		if m:
+			yield (m.group (1).lower ().replace (' ', '-'), float (m.group (2)))
+
+def run (args, stdin=None, stdout=None):
+	"""Run a command, return (wall clock seconds, stderr lines)."""
+	start = time.time ()
+	p = subprocess.Popen (args, stdin=stdin, stdout=stdout,
+	                      stderr=subprocess.PIPE, universal_newlines=True)
+	err = p.communicate ()[1]
+	elapsed = time.time () - start
+	if p.returncode != 0:
+		sys.stderr.write (err)
+		print ("%s failed with status %d" % (args[0], p.returncode), file=sys.stderr)
+		sys.exit (1)
+	return elapsed, err.splitlines ()
+
+def bench_size (n, workdir, seed, wot_opts):
+	results = []
+	d = os.path.join (workdir, str (n))
+	if not os.path.isdir (d):
+		os.makedirs (d)
+
+	dump = os.path.join (d, 'pgpring.dump')
+	keys = os.path.join (d, 'preprocess.keys')
+	outdir = os.path.join (d, 'output')
+
+	subprocess.check_call ([sys.executable, generator, '-n', str (n),
+	                        '-S', str (seed), '-f', 'pgpring', '-o', dump])
+
+	with open (dump) as fin:
+		with open (keys, 'w') as fout:
+			t, err = run ([tools['process_keys']], stdin=fin, stdout=fout)
+	results.append ((n, 'process_keys', 'total', t))
+
+	t, err = run ([tools['keyanalyze'], '-N', '-n', '-i', keys, '-o', outdir])
+	results.append ((n, 'keyanalyze', 'total', t))
+	with open (os.path.join (outdir, 'status.txt')) as f:
+		for (phase, secs) in phases (f):
+			results.append ((n, 'keyanalyze', phase, secs))
+
+	with open (os.path.join (d, 'centrality.csv'), 'w') as fout:
+		t, err = run ([tools['wot-centrality']] + wot_opts +
+		              [os.path.join (outdir, 'preprocessed.strongset')], stdout=fout)
+	results.append ((n, 'wot-centrality', 'total', t))
+	for (phase, secs) in phases (err):
+		results.append ((n, 'wot-centrality', phase, secs))
+
+	return results
+
+def read_baseline (fname):
+	baseline = {}
+	if not os.path.exists (fname):
+		return baseline
+	with open (fname) as f:
+		for line in f:
+			fields = line.strip ().split (';')
+			if len (fields) == 4:
+				baseline[(int (fields[0]), fields[1], fields[2])] = float (fields[3])
+	return baseline
+
+def write_baseline (fname, results):
+	with open (fname, 'w') as f:
+		for (n, tool, phase, secs) in results:
+			f.write ('%d;%s;%s;%.3f\n' % (n, tool, phase, secs))
+
+if __name__ == '__main__':
+	sizes    = [1000, 5000, 20000]
+	baseline = 'benchmark-baseline.csv'
+	record   = False
+	workdir  = 'benchmark'
+	seed     = 1
+	wot_opts = []
+
+	try:
+		opts, args = getopt.getopt (sys.argv[1:], 's:b:wd:S:k:p:c:W:h')
+	except getopt.GetoptError:
+		usage ()
+
+	for (o, a) in opts:
+		if o == '-s':
+			sizes = [int (s) for s in a.split (',')]
+		elif o == '-b':
+			baseline = a
+		elif o == '-w':
+			record = True
+		elif o == '-d':
+			workdir = a
+		elif o == '-S':
+			seed = int (a)
+		elif o == '-k':
+			tools['keyanalyze'] = a
+		elif o == '-p':
+			tools['process_keys'] = a
+		elif o == '-c':
+			tools['wot-centrality'] = a
+		elif o == '-W':
+			wot_opts = a.split ()
+		else:
+			usage ()
+
+	for tool in tools:
+		if not os.access (tools[tool], os.X_OK):
+			print ("%s not found at %s, build it first" % (tool, tools[tool]), file=sys.stderr)
+			sys.exit (1)
+
+	results = []
+	for n in sizes:
+		print ("Benchmarking %d keys" % n, file=sys.stderr)
+		results.extend (bench_size (n, workdir, seed, wot_opts))
+
+	base = read_baseline (baseline)
+	print ("%8s %-15s %-20s %10s %10s %7s" % ('keys', 'tool', 'phase', 'seconds', 'baseline', 'ratio'))
+	for (n, tool, phase, secs) in results:
+		b = base.get ((n, tool, phase))
+		if b:
+			print ("%8d %-15s %-20s %10.3f %10.3f %7.2f" % (n, tool, phase, secs, b, secs / b))
+		elif b is not None:
+			print ("%8d %-15s %-20s %10.3f %10.3f %7s" % (n, tool, phase, secs, b, '-'))
+		else:
+			print ("%8d %-15s %-20s %10.3f %10s %7s" % (n, tool, phase, secs, '-', '-'))
+
+	if record:
+		write_baseline (baseline, results)
+		print ("Baseline written to %s" % baseline, file=sys.stderr)
@@ -0,0 +1,252 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Generate a synthetic web of trust.
+
+The graph mimics the features of the real keyserver graph that matter
+for the analysis tools:
+
+ * a single giant strongly connected component (the "strong set"),
+   grown by preferential attachment, so that the number of signatures
+   made and received per key follows a power law;
+ * high reciprocity: most signatures inside the strong set are
+   returned;
+ * many tiny islands (mostly pairs of keys cross-signing each other)
+   hanging off the strong set with one-way signatures only;
+ * a few signatures by keys that are not in the dump.
+
+Output formats:
+ keys          preprocess.keys as read by keyanalyze and wot-centrality
+               (p<keyid>/s<keyid> lines)
+ preprocessed  process-keys.py output (s lines carry date, flags, ...)
+ pgpring       pgpring -S output, suitable for process_keys and
+               process-keys.py
+
+The output is fully determined by the options and the seed.
+"""
+
+from __future__ import print_function
+
+import sys
+import getopt
+import random
+import time
+
+DAY = 86400
+EPOCH_START = 788918400  # 1995-01-01
+EPOCH_END   = 1325376000 # 2012-01-01
+
+def usage ():
+	print ("usage: %s [-n keys] [-s strong fraction] [-r reciprocity] "
+	       "[-a exponent] [-d mean degree] [-u unknown signers] "
+	       "[-f keys|preprocessed|pgpring] [-S seed] [-o outfile]" % sys.argv[0],
+	       file=sys.stderr)
+	sys.exit (1)
+
+def powerlaw_degree (rng, alpha, kmin, kmax):
+	"""Discrete Pareto sample in [kmin, kmax]."""
+	u = rng.random ()
+	k = int (kmin * (1.0 - u) ** (-1.0 / (alpha - 1.0)))
+	return min (max (k, kmin), kmax)
+
+def isodate (t):
+	return time.strftime ('%Y-%m-%d', time.gmtime (t))
+
+class Graph:
+	def __init__ (self, n):
+		self.n       = n
+		self.ids     = []
+		self.created = [0] * n
+		self.signers = [[] for i in range (n)]   # signers[v] = [(u, date), ...]
+		self.unknown = [[] for i in range (n)]   # unknown signer ids of v
+		self.edges   = set ()
+
+	def sign (self, u, v, date):
+		"""u signs v."""
+		if u == v or (u, v) in self.edges:
+			return False
+		self.edges.add ((u, v))
+		self.signers[v].append ((u, date))
+		return True
+
+def generate (n, strong_frac, recip, alpha, mean_deg, unknown_frac, seed):
+	rng = random.Random (seed)
+	g = Graph (n)
+
+	seen = set ()
+	while len (g.ids) < n:
+		k = rng.getrandbits (64)
+		if k not in seen:
+			seen.add (k)
+			g.ids.append ('%016X' % k)
+
+	nstrong = max (2, int (n * strong_frac))
+	span = EPOCH_END - EPOCH_START
+
+	for v in range (n):
+		g.created[v] = EPOCH_START + int (span * float (v) / n * 0.9)
+
+	def sigdate (u, v):
+		t = max (g.created[u], g.created[v]) + rng.randint (0, 730) * DAY
+		return min (t, EPOCH_END)
+
+	# Strong set: preferential attachment. Every key appears in pool
+	# once plus once per signature it received, so hubs keep growing.
+	# The first signature of each new key is always returned, which
+	# keeps the whole core strongly connected.
+	kmin = max (1, int (mean_deg * (alpha - 2.0) / (alpha - 1.0)))
+	pool = [0]
+	g.sign (0, 1, sigdate (0, 1))
+	g.sign (1, 0, sigdate (1, 0))
+	pool.extend ([0, 1, 1])
+	for v in range (2, nstrong):
+		k = powerlaw_degree (rng, alpha, kmin, v)
+		first = True
+		for i in range (k):
+			t = pool[rng.randrange (len (pool))]
+			if not g.sign (v, t, sigdate (v, t)):
+				continue
+			pool.append (t)
+			if first or rng.random () < recip:
+				if g.sign (t, v, sigdate (t, v)):
+					pool.append (v)
+			first = False
+		pool.append (v)
+
+	# Islands: small groups of mutually signing keys, attached to the
+	# strong set in one direction only so they stay separate SCCs.
+	v = nstrong
+	while v < n:
+		size = powerlaw_degree (rng, 2.5, 1, n)
+		if size > 50:
+			continue
+		size = min (size, n - v)
+		members = list (range (v, v + size))
+		for i in range (1, size):
+			a, b = members[i - 1], members[i]
+			g.sign (a, b, sigdate (a, b))
+			g.sign (b, a, sigdate (b, a))
+		for i in range (size // 2):
+			a, b = rng.choice (members), rng.choice (members)
+			g.sign (a, b, sigdate (a, b))
+		anchor = pool[rng.randrange (len (pool))]
+		inbound = rng.random () < 0.7
+		for m in members:
+			if size == 1 or rng.random () < 0.3:
+				if inbound:
+					g.sign (anchor, m, sigdate (anchor, m))
+				else:
+					g.sign (m, anchor, sigdate (m, anchor))
+		v += size
+
+	# Signatures from keys that are not in the dump
+	for v in range (n):
+		if rng.random () < unknown_frac:
+			g.unknown[v].append ('%016X' % rng.getrandbits (64))
+
+	order = list (range (n))
+	rng.shuffle (order)
+	return g, order
+
+def write_keys (g, order, out):
+	for v in order:
+		sigs = g.signers[v]
+		if not sigs and not g.unknown[v]:
+			continue
+		out.write ('p%s\n' % g.ids[v])
+		for (u, d) in sigs:
+			out.write ('s%s\n' % g.ids[u])
+		for u in g.unknown[v]:
+			out.write ('s%s\n' % u)
+
+def write_preprocessed (g, order, out):
+	for v in order:
+		sigs = g.signers[v]
+		if not sigs and not g.unknown[v]:
+			continue
+		out.write ('p%s\n' % g.ids[v])
+		for (u, d) in sigs:
+			out.write ('s%s;%s;;;0;17;2;4\n' % (g.ids[u], isodate (d)))
+		for u in g.unknown[v]:
+			out.write ('s%s;%s;;;0;17;2;4\n' % (u, isodate (g.created[v])))
+
+def write_pgpring (g, order, out):
+	for v in order:
+		kid = g.ids[v]
+		created = isodate (g.created[v])
+		out.write ('pub:q:1024:17:%s:%s::4:\n' % (kid, created))
+		out.write ('uid:q::::::::Synthetic Key %d <key%d@example.org>:\n' % (v, v))
+		out.write ('sig:%s:%s::13::4:17:2\n' % (kid, created))
+		for (u, d) in g.signers[v]:
+			out.write ('sig:%s:%s::10::4:17:2\n' % (g.ids[u], isodate (d)))
+		for u in g.unknown[v]:
+			out.write ('sig:%s:%s::10::4:17:2\n' % (u, created))
+
+writers = {
+	'keys'         : write_keys,
+	'preprocessed' : write_preprocessed,
+	'pgpring'      : write_pgpring
+}
+
+if __name__ == '__main__':
+	n            = 10000
+	strong_frac  = 0.35
+	recip        = 0.7
+	alpha        = 2.2
+	mean_deg     = 8.0
+	unknown_frac = 0.05
+	fmt          = 'keys'
+	seed         = 1
+	outfile      = None
+
+	try:
+		opts, args = getopt.getopt (sys.argv[1:], 'n:s:r:a:d:u:f:S:o:h')
+	except getopt.GetoptError:
+		usage ()
+
+	for (o, a) in opts:
+		if o == '-n':
+			n = int (a)
+		elif o == '-s':
+			strong_frac = float (a)
+		elif o == '-r':
+			recip = float (a)
+		elif o == '-a':
+			alpha = float (a)
+		elif o == '-d':
+			mean_deg = float (a)
+		elif o == '-u':
+			unknown_frac = float (a)
+		elif o == '-f':
+			fmt = a
+		elif o == '-S':
+			seed = int (a)
+		elif o == '-o':
+			outfile = a
+		else:
+			usage ()
+
+	if fmt not in writers or n < 2 or alpha <= 2.0:
+		usage ()
+
+	g, order = generate (n, strong_frac, recip, alpha, mean_deg, unknown_frac, seed)
+	print ("%d keys, %d signatures" % (n, len (g.edges)), file=sys.stderr)
+
+	out = open (outfile, 'w') if outfile else sys.stdout
+	writers[fmt] (g, order, out)
+	if outfile:
+		out.close ()
@@ -0,0 +1,63 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Breadth first search */
+
+#include <stdlib.h>
+
+#include "wotgraph.h"
+
+/*
+ * Breadth first search from s. dist[] must be WG_UNREACHED for every
+ * vertex the search may enter; on return it holds the hop count of
+ * every vertex reached. If queue is not NULL (n entries) it receives
+ * the reached vertices in order of discovery. Returns the number of
+ * vertices reached, s included.
+ */
+uint32_t
+wg_bfs(const struct wg_csr * g, uint32_t s, uint32_t * dist, uint32_t * queue)
+{
+	uint32_t       *q = queue;
+	uint32_t        head = 0, tail = 0, v, w;
+	size_t          e;
+
+	if (q == NULL)
+		q = wg_malloc(g->n * sizeof(uint32_t));
+
+	dist[s] = 0;
+	q[tail++] = s;
+	while (head < tail) {
+		v = q[head++];
+		for (e = g->off[v]; e < g->off[v + 1]; e++) {
+			w = g->adj[e];
+			if (dist[w] == WG_UNREACHED) {
+				dist[w] = dist[v] + 1;
+				q[tail++] = w;
+			}
+		}
+	}
+
+	if (q != queue)
+		free(q);
+	return tail;
+}
@@ -0,0 +1,162 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Edge lists and CSR adjacency */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "wotgraph.h"
+
+void
+wg_edges_init(struct wg_edges * e)
+{
+	e->n = 0;
+	e->cap = 1024;
+	e->src = wg_malloc(e->cap * sizeof(uint32_t));
+	e->dst = wg_malloc(e->cap * sizeof(uint32_t));
+	e->date = NULL;
+}
+
+void
+wg_edges_free(struct wg_edges * e)
+{
+	free(e->src);
+	free(e->dst);
+	free(e->date);
+	e->src = e->dst = NULL;
+	e->date = NULL;
+	e->n = e->cap = 0;
+}
+
+void
+wg_edges_add(struct wg_edges * e, uint32_t src, uint32_t dst)
+{
+	if (e->n == e->cap) {
+		e->cap *= 2;
+		e->src = wg_realloc(e->src, e->cap * sizeof(uint32_t));
+		e->dst = wg_realloc(e->dst, e->cap * sizeof(uint32_t));
+	}
+	e->src[e->n] = src;
+	e->dst[e->n] = dst;
+	e->n++;
+}
+
+/*
+ * Sort the edges by (signer, signee) and drop duplicates, in O(m):
+ * LSD radix sort of the 64 bit keys signer << 32 | signee, 16 bits
+ * per pass, skipping passes whose digit is the same for all keys.
+ * The dates, if any, are dropped.
+ */
+void
+wg_edges_dedup(struct wg_edges * e)
+{
+	uint64_t       *a, *b, *t;
+	size_t          i, j, *cnt, sum, c;
+	int             shift;
+
+	free(e->date);
+	e->date = NULL;
+	if (e->n == 0)
+		return;
+
+	a = wg_malloc(e->n * sizeof(uint64_t));
+	b = wg_malloc(e->n * sizeof(uint64_t));
+	cnt = wg_malloc(65536 * sizeof(size_t));
+	for (i = 0; i < e->n; i++)
+		a[i] = (uint64_t) e->src[i] << 32 | e->dst[i];
+
+	for (shift = 0; shift < 64; shift += 16) {
+		memset(cnt, 0, 65536 * sizeof(size_t));
+		for (i = 0; i < e->n; i++)
+			cnt[(a[i] >> shift) & 0xffff]++;
+		if (cnt[(a[0] >> shift) & 0xffff] == e->n)
+			continue;
+		for (sum = 0, j = 0; j < 65536; j++) {
+			c = cnt[j];
+			cnt[j] = sum;
+			sum += c;
+		}
+		for (i = 0; i < e->n; i++)
+			b[cnt[(a[i] >> shift) & 0xffff]++] = a[i];
+		t = a;
+		a = b;
+		b = t;
+	}
+
+	for (i = 0, j = 0; i < e->n; i++) {
+		if (j > 0 && a[i] == a[i - 1])
+			continue;
+		e->src[j] = (uint32_t) (a[i] >> 32);
+		e->dst[j] = (uint32_t) a[i];
+		j++;
+	}
+	e->n = j;
+
+	free(a);
+	free(b);
+	free(cnt);
+}
+
+/*
+ * Build the adjacency of the n vertex graph e, either signer ->
+ * signees (WG_FORWARD) or signee -> signers (WG_REVERSE). This is a
+ * counting sort, so every row keeps the input order of its edges.
+ */
+void
+wg_csr_build(struct wg_csr * g, uint32_t n, const struct wg_edges * e, int dir)
+{
+	const uint32_t *from, *to;
+	size_t          i, *pos;
+	uint32_t        v;
+
+	from = dir == WG_REVERSE ? e->dst : e->src;
+	to = dir == WG_REVERSE ? e->src : e->dst;
+
+	g->n = n;
+	g->m = e->n;
+	g->off = wg_calloc(n + 1, sizeof(size_t));
+	g->adj = wg_malloc(e->n * sizeof(uint32_t));
+
+	for (i = 0; i < e->n; i++)
+		g->off[from[i] + 1]++;
+	for (v = 0; v < n; v++)
+		g->off[v + 1] += g->off[v];
+
+	pos = wg_malloc((n + 1) * sizeof(size_t));
+	memcpy(pos, g->off, (n + 1) * sizeof(size_t));
+	for (i = 0; i < e->n; i++)
+		g->adj[pos[from[i]]++] = to[i];
+	free(pos);
+}
+
+void
+wg_csr_free(struct wg_csr * g)
+{
+	free(g->off);
+	free(g->adj);
+	g->off = NULL;
+	g->adj = NULL;
+	g->n = 0;
+	g->m = 0;
+}
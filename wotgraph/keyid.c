@@ -0,0 +1,191 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Key ids, the interning table and allocation helpers */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wotgraph.h"
+
+void           *
+wg_malloc(size_t size)
+{
+	void           *p;
+
+	if ((p = malloc(size ? size : 1)) == NULL) {
+		fprintf(stderr, "malloc failed\n");
+		exit(2);
+	}
+	return p;
+}
+
+void           *
+wg_calloc(size_t nmemb, size_t size)
+{
+	void           *p;
+
+	if ((p = calloc(nmemb ? nmemb : 1, size ? size : 1)) == NULL) {
+		fprintf(stderr, "malloc failed\n");
+		exit(2);
+	}
+	return p;
+}
+
+void           *
+wg_realloc(void *ptr, size_t size)
+{
+	void           *p;
+
+	if ((p = realloc(ptr, size ? size : 1)) == NULL) {
+		fprintf(stderr, "malloc failed\n");
+		exit(2);
+	}
+	return p;
+}
+
+/*
+ * Parse len hex digits at s into *id. Returns -1 if one of them is
+ * not a hex digit.
+ */
+int
+wg_keyid_parse(const char *s, int len, wg_keyid_t * id)
+{
+	wg_keyid_t      v = 0;
+	int             i, c;
+
+	for (i = 0; i < len; i++) {
+		c = (unsigned char) s[i];
+		if (c >= '0' && c <= '9')
+			c -= '0';
+		else if (c >= 'A' && c <= 'F')
+			c -= 'A' - 10;
+		else if (c >= 'a' && c <= 'f')
+			c -= 'a' - 10;
+		else
+			return -1;
+		v = (v << 4) | (wg_keyid_t) c;
+	}
+	*id = v;
+	return 0;
+}
+
+/*
+ * Write id as len upper case hex digits plus NUL to buf, which must
+ * hold len + 1 bytes.
+ */
+char           *
+wg_keyid_format(wg_keyid_t id, int len, char *buf)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	int             i;
+
+	for (i = len - 1; i >= 0; i--) {
+		buf[i] = hex[id & 0xf];
+		id >>= 4;
+	}
+	buf[len] = '\0';
+	return buf;
+}
+
+static size_t
+idtab_hash(wg_keyid_t id, size_t nslots)
+{
+	/* Fibonacci hashing; nslots is a power of two */
+	return (size_t) ((id * 0x9E3779B97F4A7C15ULL) >> 32) & (nslots - 1);
+}
+
+void
+wg_idtab_init(struct wg_idtab * t)
+{
+	t->n = 0;
+	t->cap = 1024;
+	t->nslots = 2048;
+	t->ids = wg_malloc(t->cap * sizeof(wg_keyid_t));
+	t->slots = wg_calloc(t->nslots, sizeof(uint32_t));
+}
+
+void
+wg_idtab_free(struct wg_idtab * t)
+{
+	free(t->ids);
+	free(t->slots);
+	t->ids = NULL;
+	t->slots = NULL;
+	t->n = t->cap = 0;
+	t->nslots = 0;
+}
+
+/* Vertex number of id, -1 if it is not in the table */
+int64_t
+wg_idtab_find(const struct wg_idtab * t, wg_keyid_t id)
+{
+	size_t          h;
+	uint32_t        s;
+
+	for (h = idtab_hash(id, t->nslots); (s = t->slots[h]); h = (h + 1) & (t->nslots - 1)) {
+		if (t->ids[s - 1] == id)
+			return s - 1;
+	}
+	return -1;
+}
+
+static void
+idtab_grow(struct wg_idtab * t)
+{
+	uint32_t        v;
+	size_t          h;
+
+	free(t->slots);
+	t->nslots *= 2;
+	t->slots = wg_calloc(t->nslots, sizeof(uint32_t));
+	for (v = 0; v < t->n; v++) {
+		for (h = idtab_hash(t->ids[v], t->nslots); t->slots[h]; h = (h + 1) & (t->nslots - 1));
+		t->slots[h] = v + 1;
+	}
+}
+
+/* Vertex number of id, which is added if it is new */
+uint32_t
+wg_idtab_intern(struct wg_idtab * t, wg_keyid_t id)
+{
+	size_t          h;
+	uint32_t        s;
+
+	for (h = idtab_hash(id, t->nslots); (s = t->slots[h]); h = (h + 1) & (t->nslots - 1)) {
+		if (t->ids[s - 1] == id)
+			return s - 1;
+	}
+	if (t->n == t->cap) {
+		t->cap *= 2;
+		t->ids = wg_realloc(t->ids, t->cap * sizeof(wg_keyid_t));
+	}
+	t->ids[t->n] = id;
+	t->slots[h] = ++t->n;
+
+	/* keep the load factor below one half */
+	if (2 * (size_t) t->n > t->nslots)
+		idtab_grow(t);
+	return t->n - 1;
+}
@@ -0,0 +1,136 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Reader for preprocess.keys style graph files */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wotgraph.h"
+
+/* a signature whose signer has not been resolved yet */
+struct pending {
+	wg_keyid_t      signer;
+	uint32_t        signee;
+	int32_t         date;
+};
+
+/*
+ * Read a graph file. We expect sequences of lines
+ *
+ *	p<keyid>
+ *	s<keyid>
+ *	...
+ *
+ * where lines starting with 'p' introduce a public key and lines
+ * starting with 's' the signatures on that key. Key ids are idlen hex
+ * digits; whatever follows them (e.g. the ;-separated fields of
+ * process-keys.py output) is ignored, and so are lines that do not
+ * fit the format. With WG_DATES the date of every signature is taken
+ * from an s<keyid>;yyyy-mm-dd;... line into g->sigs.date.
+ *
+ * The file is read once: keys are numbered in the order of their p
+ * lines, signatures are buffered and resolved at the end, so they may
+ * refer to keys introduced later on. Signatures by keys without a p
+ * line are dropped and counted in g->unknown.
+ *
+ * Returns 0, or -1 on a read error.
+ */
+int
+wg_load(struct wg_graph * g, FILE * fp, int idlen, int flags)
+{
+	char            line[1024];
+	struct pending *pend;
+	size_t          npend = 0, cap = 1024, i, len;
+	int64_t         cur = -1, signer;
+	wg_keyid_t      id;
+	int             partial = 0;
+
+	wg_idtab_init(&g->keys);
+	wg_edges_init(&g->sigs);
+	g->unknown = g->selfsigs = g->malformed = 0;
+
+	pend = wg_malloc(cap * sizeof(struct pending));
+
+	while (fgets(line, sizeof(line), fp)) {
+		/* skip the tail of over-long lines */
+		len = strlen(line);
+		if (partial) {
+			partial = line[len - 1] != '\n';
+			continue;
+		}
+		partial = line[len - 1] != '\n';
+
+		if ((int) len < idlen + 1 || wg_keyid_parse(line + 1, idlen, &id) != 0)
+			continue;
+
+		if (line[0] == 'p') {
+			cur = wg_idtab_intern(&g->keys, id);
+		} else if (line[0] == 's') {
+			if (cur < 0) {
+				g->malformed++;
+				continue;
+			}
+			if (npend == cap) {
+				cap *= 2;
+				pend = wg_realloc(pend, cap * sizeof(struct pending));
+			}
+			pend[npend].signer = id;
+			pend[npend].signee = cur;
+			pend[npend].date = WG_NODATE;
+			if ((flags & WG_DATES) && line[idlen + 1] == ';')
+				wg_date_parse(line + idlen + 2, &pend[npend].date);
+			npend++;
+		}
+	}
+	if (ferror(fp)) {
+		free(pend);
+		return -1;
+	}
+
+	if (flags & WG_DATES)
+		g->sigs.date = wg_malloc(npend * sizeof(int32_t));
+	for (i = 0; i < npend; i++) {
+		if ((signer = wg_idtab_find(&g->keys, pend[i].signer)) < 0) {
+			g->unknown++;
+			continue;
+		}
+		if (signer == pend[i].signee && (flags & WG_SKIP_SELFSIGS)) {
+			g->selfsigs++;
+			continue;
+		}
+		if (flags & WG_DATES)
+			g->sigs.date[g->sigs.n] = pend[i].date;
+		wg_edges_add(&g->sigs, signer, pend[i].signee);
+	}
+	free(pend);
+	return 0;
+}
+
+void
+wg_graph_free(struct wg_graph * g)
+{
+	wg_idtab_free(&g->keys);
+	wg_edges_free(&g->sigs);
+}
@@ -0,0 +1,131 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Strongly connected components */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "wotgraph.h"
+
+/*
+ * Tarjan's algorithm, with an explicit stack instead of recursion so
+ * the depth of the graph cannot overflow the C stack. Vertices and
+ * edges are visited in the same order as by the recursive version:
+ * components are numbered in order of completion and their members
+ * are listed in the order they are popped off the stack, the vertex
+ * that closes the component last.
+ */
+void
+wg_scc(const struct wg_csr * g, struct wg_scc * r)
+{
+	uint32_t        n = g->n;
+	uint32_t       *dfsnum, *low, *stack, *call;
+	size_t         *next;
+	uint32_t        sp = 0, cp, s, v, w, lastnum = 0, nmem = 0, c;
+	size_t          best = 0;
+
+	dfsnum = wg_calloc(n, sizeof(uint32_t));
+	low = wg_malloc(n * sizeof(uint32_t));
+	stack = wg_malloc(n * sizeof(uint32_t));
+	call = wg_malloc(n * sizeof(uint32_t));
+	next = wg_malloc(n * sizeof(size_t));
+
+	r->ncomp = 0;
+	r->giant = 0;
+	r->comp = wg_malloc(n * sizeof(uint32_t));
+	r->root = wg_malloc(n * sizeof(uint32_t));
+	r->members = wg_malloc(n * sizeof(uint32_t));
+	r->off = wg_malloc((n + 1) * sizeof(size_t));
+	r->off[0] = 0;
+
+	/* comp[v] == n: not yet assigned to a component */
+	for (v = 0; v < n; v++)
+		r->comp[v] = n;
+
+	for (s = 0; s < n; s++) {
+		if (dfsnum[s])
+			continue;
+
+		cp = 0;
+		call[cp++] = s;
+		dfsnum[s] = low[s] = ++lastnum;
+		stack[sp++] = s;
+		next[s] = g->off[s];
+
+		while (cp) {
+			v = call[cp - 1];
+			if (next[v] < g->off[v + 1]) {
+				w = g->adj[next[v]++];
+				if (r->comp[w] != n)
+					continue;
+				if (!dfsnum[w]) {
+					/* descend */
+					dfsnum[w] = low[w] = ++lastnum;
+					stack[sp++] = w;
+					next[w] = g->off[w];
+					call[cp++] = w;
+				} else if (dfsnum[w] < low[v])
+					low[v] = dfsnum[w];
+				continue;
+			}
+
+			/* all edges of v done: return to the caller */
+			cp--;
+			if (low[v] == dfsnum[v]) {
+				c = r->ncomp++;
+				do {
+					w = stack[--sp];
+					r->comp[w] = c;
+					r->members[nmem++] = w;
+				} while (w != v);
+				r->root[c] = v;
+				r->off[c + 1] = nmem;
+				if (r->off[c + 1] - r->off[c] > best) {
+					best = r->off[c + 1] - r->off[c];
+					r->giant = c;
+				}
+			}
+			if (cp && low[v] < low[call[cp - 1]])
+				low[call[cp - 1]] = low[v];
+		}
+	}
+
+	free(dfsnum);
+	free(low);
+	free(stack);
+	free(call);
+	free(next);
+}
+
+void
+wg_scc_free(struct wg_scc * r)
+{
+	free(r->comp);
+	free(r->root);
+	free(r->members);
+	free(r->off);
+	r->comp = r->root = r->members = NULL;
+	r->off = NULL;
+	r->ncomp = 0;
+}
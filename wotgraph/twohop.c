@@ -0,0 +1,234 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Two-hop neighbourhoods: for every vertex v the number of vertices
+ * reachable over one or two edges, v itself not counted.
+ *
+ * Most vertices are counted exactly by marking their neighbours in a
+ * bitset. For hubs, whose neighbours have many neighbours again, the
+ * count is estimated instead by merging HyperLogLog sketches of the
+ * neighbours' closed neighbourhoods (Flajolet et al., "HyperLogLog:
+ * the analysis of a near-optimal cardinality estimation algorithm",
+ * 2007), which costs WG_HLL_REGS per neighbour instead of its degree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "wotgraph.h"
+
+#define HLL_BITS	(64 - WG_HLL_P)
+
+static uint64_t
+mix64(uint64_t x)
+{
+	/* splitmix64 finalizer */
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+}
+
+static void
+hll_add(uint8_t * reg, uint32_t v)
+{
+	uint64_t        h = mix64((uint64_t) v + 1), w;
+	uint8_t         rho;
+
+	/* leading zeros of the low HLL_BITS bits, plus one */
+	w = h << WG_HLL_P;
+	for (rho = 1; rho <= HLL_BITS && !(w >> 63); rho++)
+		w <<= 1;
+	h >>= HLL_BITS;
+	if (reg[h] < rho)
+		reg[h] = rho;
+}
+
+static double
+hll_count(const uint8_t * reg)
+{
+	double          m = WG_HLL_REGS, sum = 0.0, e;
+	int             i, zeros = 0;
+
+	for (i = 0; i < WG_HLL_REGS; i++) {
+		sum += ldexp(1.0, -reg[i]);
+		if (reg[i] == 0)
+			zeros++;
+	}
+	e = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+	if (e <= 2.5 * m && zeros > 0)
+		e = m * log(m / zeros);	/* linear counting */
+	return e;
+}
+
+/* Edges a count of v's two-hop neighbourhood looks at */
+static size_t
+twohop_work(const struct wg_csr * g, uint32_t v)
+{
+	size_t          e, work = 0;
+
+	for (e = g->off[v]; e < g->off[v + 1]; e++)
+		work += g->off[g->adj[e] + 1] - g->off[g->adj[e]];
+	return work;
+}
+
+/*
+ * Prepare counting two-hop neighbourhoods in g. Vertices whose count
+ * would look at more than hubwork edges are estimated; hubwork 0
+ * counts every vertex exactly. The sketches the hubs need are built
+ * here, so that wg_twohop_count() only reads t and may run in
+ * several threads at once.
+ */
+void
+wg_twohop_init(struct wg_twohop * t, const struct wg_csr * g, size_t hubwork)
+{
+	uint32_t        v, u, nsk = 0;
+	size_t          e, f;
+	uint8_t        *reg;
+
+	t->g = g;
+	t->hub = wg_calloc(g->n, 1);
+	t->sketchof = wg_malloc(g->n * sizeof(uint32_t));
+	t->sketch = NULL;
+	t->nhubs = 0;
+	for (v = 0; v < g->n; v++)
+		t->sketchof[v] = UINT32_MAX;
+	if (hubwork == 0)
+		return;
+
+	for (v = 0; v < g->n; v++) {
+		if (twohop_work(g, v) <= hubwork)
+			continue;
+		t->hub[v] = 1;
+		t->nhubs++;
+		for (e = g->off[v]; e < g->off[v + 1]; e++) {
+			u = g->adj[e];
+			if (t->sketchof[u] == UINT32_MAX)
+				t->sketchof[u] = nsk++;
+		}
+	}
+
+	/* sketch of the closed neighbourhood of every hub neighbour */
+	t->sketch = wg_calloc((size_t) nsk * WG_HLL_REGS, 1);
+	for (u = 0; u < g->n; u++) {
+		if (t->sketchof[u] == UINT32_MAX)
+			continue;
+		reg = t->sketch + (size_t) t->sketchof[u] * WG_HLL_REGS;
+		hll_add(reg, u);
+		for (f = g->off[u]; f < g->off[u + 1]; f++)
+			hll_add(reg, g->adj[f]);
+	}
+}
+
+void
+wg_twohop_free(struct wg_twohop * t)
+{
+	free(t->hub);
+	free(t->sketchof);
+	free(t->sketch);
+	t->hub = NULL;
+	t->sketchof = NULL;
+	t->sketch = NULL;
+}
+
+/*
+ * Scratch space for counting in t's graph, allocated once per thread
+ * and handed to every wg_twohop_count() call of that thread.
+ */
+void
+wg_twohop_scratch_init(struct wg_twohop_scratch * s, const struct wg_twohop * t)
+{
+	s->mark = wg_calloc(t->g->n / 64 + 1, sizeof(uint64_t));
+	s->touched = wg_malloc(t->g->n * sizeof(uint32_t));
+}
+
+void
+wg_twohop_scratch_free(struct wg_twohop_scratch * s)
+{
+	free(s->mark);
+	free(s->touched);
+	s->mark = NULL;
+	s->touched = NULL;
+}
+
+/*
+ * Two-hop neighbourhood sizes of the vertices first .. last - 1 into
+ * size[first] .. size[last - 1]. Only the marks set are cleared
+ * again, so a call costs the edges looked at, not the size of g.
+ */
+void
+wg_twohop_count(const struct wg_twohop * t, struct wg_twohop_scratch * s,
+		uint32_t first, uint32_t last, double *size)
+{
+	const struct wg_csr *g = t->g;
+	uint64_t       *mark = s->mark;
+	uint32_t       *touched = s->touched, ntouched, v, u, w, i;
+	uint8_t         reg[WG_HLL_REGS];
+	const uint8_t  *su;
+	size_t          e, f;
+	double          est;
+
+	for (v = first; v < last; v++) {
+		if (t->hub[v]) {
+			memset(reg, 0, sizeof(reg));
+			hll_add(reg, v);
+			for (e = g->off[v]; e < g->off[v + 1]; e++) {
+				su = t->sketch + (size_t) t->sketchof[g->adj[e]] * WG_HLL_REGS;
+				for (i = 0; i < WG_HLL_REGS; i++)
+					reg[i] = (su[i] > reg[i]) ? su[i] : reg[i];
+			}
+			/* the one-hop neighbours are known exactly */
+			est = hll_count(reg) - 1.0;
+			if (est < (double) (g->off[v + 1] - g->off[v]))
+				est = (double) (g->off[v + 1] - g->off[v]);
+			size[v] = floor(est + 0.5);
+			continue;
+		}
+
+		/* v is marked so that it does not count itself */
+		mark[v / 64] |= (uint64_t) 1 << (v % 64);
+		touched[0] = v;
+		ntouched = 1;
+		for (e = g->off[v]; e < g->off[v + 1]; e++) {
+			u = g->adj[e];
+			if (!(mark[u / 64] & ((uint64_t) 1 << (u % 64)))) {
+				mark[u / 64] |= (uint64_t) 1 << (u % 64);
+				touched[ntouched++] = u;
+			}
+			for (f = g->off[u]; f < g->off[u + 1]; f++) {
+				w = g->adj[f];
+				if (!(mark[w / 64] & ((uint64_t) 1 << (w % 64)))) {
+					mark[w / 64] |= (uint64_t) 1 << (w % 64);
+					touched[ntouched++] = w;
+				}
+			}
+		}
+		size[v] = (double) (ntouched - 1);
+		for (i = 0; i < ntouched; i++)
+			mark[touched[i] / 64] = 0;
+	}
+}
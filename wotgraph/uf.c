@@ -0,0 +1,183 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Union-find over vertex numbers */
+
+#include <stdlib.h>
+
+#include "wotgraph.h"
+
+void
+wg_uf_init(struct wg_uf * u, uint32_t n)
+{
+	uint32_t        v;
+
+	u->n = n;
+	u->parent = wg_malloc(n * sizeof(uint32_t));
+	u->size = wg_malloc(n * sizeof(uint32_t));
+	for (v = 0; v < n; v++) {
+		u->parent[v] = v;
+		u->size[v] = 1;
+	}
+}
+
+void
+wg_uf_free(struct wg_uf * u)
+{
+	free(u->parent);
+	free(u->size);
+	u->parent = u->size = NULL;
+	u->n = 0;
+}
+
+/* Representative of v's set, halving the path on the way */
+uint32_t
+wg_uf_find(struct wg_uf * u, uint32_t v)
+{
+	while (u->parent[v] != v) {
+		u->parent[v] = u->parent[u->parent[v]];
+		v = u->parent[v];
+	}
+	return v;
+}
+
+/*
+ * Merge the sets of a and b, the smaller one under the larger.
+ * Returns the representative of the union.
+ */
+uint32_t
+wg_uf_union(struct wg_uf * u, uint32_t a, uint32_t b)
+{
+	uint32_t        t;
+
+	a = wg_uf_find(u, a);
+	b = wg_uf_find(u, b);
+	if (a == b)
+		return a;
+	if (u->size[a] < u->size[b]) {
+		t = a;
+		a = b;
+		b = t;
+	}
+	u->parent[b] = a;
+	u->size[a] += u->size[b];
+	return a;
+}
+
+void
+wg_tuf_init(struct wg_tuf * u, uint32_t n)
+{
+	uint32_t        v;
+
+	u->n = n;
+	u->parent = wg_malloc(n * sizeof(uint32_t));
+	u->size = wg_malloc(n * sizeof(uint32_t));
+	u->when = wg_malloc(n * sizeof(int32_t));
+	for (v = 0; v < n; v++) {
+		u->parent[v] = v;
+		u->size[v] = 1;
+		u->when[v] = WG_NODATE;
+	}
+}
+
+void
+wg_tuf_free(struct wg_tuf * u)
+{
+	free(u->parent);
+	free(u->size);
+	free(u->when);
+	u->parent = u->size = NULL;
+	u->when = NULL;
+	u->n = 0;
+}
+
+/* Representative of v's set; the trees are never changed by a lookup */
+uint32_t
+wg_tuf_find(const struct wg_tuf * u, uint32_t v)
+{
+	while (u->parent[v] != v)
+		v = u->parent[v];
+	return v;
+}
+
+/*
+ * Merge the sets of a and b at time when, which must not be earlier
+ * than that of any previous merge. Returns 1 if they were separate.
+ */
+int
+wg_tuf_union(struct wg_tuf * u, uint32_t a, uint32_t b, int32_t when)
+{
+	uint32_t        t;
+
+	a = wg_tuf_find(u, a);
+	b = wg_tuf_find(u, b);
+	if (a == b)
+		return 0;
+	if (u->size[a] < u->size[b]) {
+		t = a;
+		a = b;
+		b = t;
+	}
+	u->parent[b] = a;
+	u->size[a] += u->size[b];
+	u->when[b] = when;
+	return 1;
+}
+
+/*
+ * Time from which a and b are in one set, WG_NODATE if they never
+ * are. The when[] on a path up the tree only grow, so this is the
+ * later of the two last steps below the lowest common ancestor:
+ * O(log n) without any per-query state.
+ */
+int32_t
+wg_tuf_when(const struct wg_tuf * u, uint32_t a, uint32_t b)
+{
+	uint32_t        da = 0, db = 0, ra, rb;
+	int32_t         t = INT32_MIN;
+
+	if (a == b)
+		return INT32_MIN;
+	for (ra = a; u->parent[ra] != ra; ra = u->parent[ra])
+		da++;
+	for (rb = b; u->parent[rb] != rb; rb = u->parent[rb])
+		db++;
+	if (ra != rb)
+		return WG_NODATE;
+
+	/* climb to equal depth, then in step */
+	for (; da > db; da--) {
+		t = u->when[a];
+		a = u->parent[a];
+	}
+	for (; db > da; db--) {
+		t = u->when[b];
+		b = u->parent[b];
+	}
+	while (a != b) {
+		t = u->when[a] > u->when[b] ? u->when[a] : u->when[b];
+		a = u->parent[a];
+		b = u->parent[b];
+	}
+	return t;
+}
@@ -0,0 +1,199 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * wotgraph: the graph core shared by keyanalyze and wot-centrality.
+ *
+ * Keys are interned into dense vertex numbers 0..n-1 in the order
+ * their "p" lines appear, signatures are kept as (signer, signee)
+ * pairs and turned into CSR adjacency for the graph kernels.
+ */
+
+#ifndef _WOTGRAPH_H
+#define _WOTGRAPH_H
+
+#include <sys/time.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint64_t wg_keyid_t;
+
+/* date of signatures that carry none */
+#define WG_NODATE	INT32_MAX
+
+/* distance of vertices a BFS did not reach */
+#define WG_UNREACHED	UINT32_MAX
+
+/* Key id <-> vertex number table (open addressing hash) */
+struct wg_idtab {
+	wg_keyid_t     *ids;	/* ids[v] is the key id of vertex v */
+	uint32_t       *slots;	/* vertex + 1, 0 marks a free slot */
+	uint32_t        n;
+	uint32_t        cap;
+	size_t          nslots;
+};
+
+/*
+ * Signatures as (signer, signee) vertex pairs, in input order. date
+ * is NULL unless wg_load() was asked for WG_DATES, then it holds the
+ * day of every signature (days since 1970-01-01 or WG_NODATE).
+ */
+struct wg_edges {
+	uint32_t       *src;
+	uint32_t       *dst;
+	int32_t        *date;
+	size_t          n;
+	size_t          cap;
+};
+
+/*
+ * Compressed sparse row adjacency: the neighbours of v are
+ * adj[off[v]] .. adj[off[v+1] - 1].
+ */
+struct wg_csr {
+	uint32_t        n;
+	size_t          m;
+	size_t         *off;
+	uint32_t       *adj;
+};
+
+/* What wg_load() read */
+struct wg_graph {
+	struct wg_idtab keys;
+	struct wg_edges sigs;
+	size_t          unknown;	/* signatures by keys without a p line */
+	size_t          selfsigs;	/* skipped with WG_SKIP_SELFSIGS */
+	size_t          malformed;	/* s lines before the first p line */
+};
+
+/* Strongly connected components, numbered in order of completion */
+struct wg_scc {
+	uint32_t        ncomp;
+	uint32_t       *comp;	/* comp[v] is the component of v */
+	uint32_t       *root;	/* vertex that closed each component */
+	uint32_t       *members;	/* vertices grouped by component */
+	size_t         *off;	/* members of c: off[c] .. off[c+1] - 1 */
+	uint32_t        giant;	/* first component of maximal size */
+};
+
+/* Disjoint sets; size[r] is the size of the set with representative r */
+struct wg_uf {
+	uint32_t       *parent;
+	uint32_t       *size;
+	uint32_t        n;
+};
+
+/*
+ * Disjoint sets that remember when they were merged: union by size
+ * without path compression keeps every tree O(log n) deep, and
+ * when[v] is the time v's root was put under its parent. Two vertices
+ * are in one set from the latest when[] on their tree paths to the
+ * lowest common ancestor on.
+ */
+struct wg_tuf {
+	uint32_t       *parent;
+	uint32_t       *size;
+	int32_t        *when;
+	uint32_t        n;
+};
+
+/* HyperLogLog sketches of 2^WG_HLL_P registers, about 3% error */
+#define WG_HLL_P	10
+#define WG_HLL_REGS	(1 << WG_HLL_P)
+
+/* Two-hop neighbourhood counts, see twohop.c */
+struct wg_twohop {
+	const struct wg_csr *g;
+	uint8_t        *hub;	/* hub[v]: v is estimated, not counted */
+	uint32_t        nhubs;
+	uint32_t       *sketchof;	/* sketch number of v, UINT32_MAX if none */
+	uint8_t        *sketch;	/* WG_HLL_REGS registers per sketch */
+};
+
+/* Marks of one wg_twohop_count() caller, all clear between vertices */
+struct wg_twohop_scratch {
+	uint64_t       *mark;	/* bitset of the vertices seen */
+	uint32_t       *touched;	/* the vertices set in mark */
+};
+
+/* wg_load() flags */
+#define WG_SKIP_SELFSIGS	0x01
+#define WG_DATES	0x02	/* keep the signature dates in sigs.date */
+
+/* wg_csr_build() directions */
+#define WG_FORWARD	0	/* signer -> signees */
+#define WG_REVERSE	1	/* signee -> signers */
+
+void           *wg_malloc(size_t);
+void           *wg_calloc(size_t, size_t);
+void           *wg_realloc(void *, size_t);
+
+int             wg_keyid_parse(const char *, int, wg_keyid_t *);
+char           *wg_keyid_format(wg_keyid_t, int, char *);
+
+int             wg_date_parse(const char *, int32_t *);
+char           *wg_date_format(int32_t, char *);
+
+double          wg_lap(struct timeval *);
+
+void            wg_idtab_init(struct wg_idtab *);
+void            wg_idtab_free(struct wg_idtab *);
+int64_t         wg_idtab_find(const struct wg_idtab *, wg_keyid_t);
+uint32_t        wg_idtab_intern(struct wg_idtab *, wg_keyid_t);
+
+void            wg_edges_init(struct wg_edges *);
+void            wg_edges_free(struct wg_edges *);
+void            wg_edges_add(struct wg_edges *, uint32_t, uint32_t);
+void            wg_edges_dedup(struct wg_edges *);
+
+void            wg_csr_build(struct wg_csr *, uint32_t, const struct wg_edges *, int);
+void            wg_csr_free(struct wg_csr *);
+
+int             wg_load(struct wg_graph *, FILE *, int, int);
+void            wg_graph_free(struct wg_graph *);
+
+void            wg_scc(const struct wg_csr *, struct wg_scc *);
+void            wg_scc_free(struct wg_scc *);
+
+uint32_t        wg_bfs(const struct wg_csr *, uint32_t, uint32_t *, uint32_t *);
+
+void            wg_uf_init(struct wg_uf *, uint32_t);
+void            wg_uf_free(struct wg_uf *);
+uint32_t        wg_uf_find(struct wg_uf *, uint32_t);
+uint32_t        wg_uf_union(struct wg_uf *, uint32_t, uint32_t);
+
+void            wg_tuf_init(struct wg_tuf *, uint32_t);
+void            wg_tuf_free(struct wg_tuf *);
+uint32_t        wg_tuf_find(const struct wg_tuf *, uint32_t);
+int             wg_tuf_union(struct wg_tuf *, uint32_t, uint32_t, int32_t);
+int32_t         wg_tuf_when(const struct wg_tuf *, uint32_t, uint32_t);
+
+void            wg_twohop_init(struct wg_twohop *, const struct wg_csr *, size_t);
+void            wg_twohop_free(struct wg_twohop *);
+void            wg_twohop_scratch_init(struct wg_twohop_scratch *, const struct wg_twohop *);
+void            wg_twohop_scratch_free(struct wg_twohop_scratch *);
+void            wg_twohop_count(const struct wg_twohop *, struct wg_twohop_scratch *,
+				uint32_t, uint32_t, double *);
+
+#endif				/* _WOTGRAPH_H */